@@ -1,9 +1,19 @@
 #pragma once
 #include "include/common.h"
+#include "include/clock.hpp"
 
 #include "include/crc.h"
 #include "include/sbu.h"
+#include "include/schema.hpp"
 #include "include/fifo.h"
+#include "include/stats.hpp"
+#include "include/trace.hpp"
 #include "include/stream.hpp"
+#include "include/basic_stream.hpp"
+#include "include/buffered.hpp"
 #include "include/serial.hpp"
-#include "include/socket.hpp"
\ No newline at end of file
+#include "include/discovery.hpp"
+#include "include/socket.hpp"
+#include "include/ring_stream.hpp"
+#include "include/chain.hpp"
+#include "include/async.hpp"
\ No newline at end of file
@@ -0,0 +1,260 @@
+/*
+ * serial_bench.cpp - PTY loopback benchmark for uSerial
+ *
+ * Меряет пропускную способность, поток мелких сообщений и RTT
+ * на паре псевдотерминалов, без железа. Результат - JSON.
+ *
+ * g++ -O2 -std=c++17 -Iinclude bench/serial_bench.cpp script/serial.cpp -o serial_bench -pthread
+ * ./serial_bench [out.json] [bulk_mb]
+ */
+
+#include "serial.hpp"
+
+#include <stdio.h>
+#include <time.h>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+enum ReadMode
+{
+    READ_POLL,  // poll() + read()
+    READ_SPIN,  // setBusyPoll() + read()
+    READ_BYTES, // uStream::readBytes()
+};
+
+static const char *modeName(ReadMode mode)
+{
+    switch (mode)
+    {
+    case READ_POLL:
+        return "poll";
+    case READ_SPIN:
+        return "spin";
+    case READ_BYTES:
+        return "readBytes";
+    }
+    return "?";
+}
+
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static bool writeAll(uSerial &port, const uint8_t *data, size_t len)
+{
+    while (len > 0)
+    {
+        ssize_t n = (ssize_t)port.write(data, len);
+        if (n <= 0)
+            return false;
+        data += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+static size_t readSome(uSerial &port, ReadMode mode, uint8_t *buf, size_t len)
+{
+    if (mode == READ_BYTES)
+        return port.readBytes(buf, len, 5000) ? len : 0;
+    if (!port.poll(5000))
+        return 0;
+    ssize_t n = (ssize_t)port.read(buf, len);
+    return n > 0 ? (size_t)n : 0;
+}
+
+static bool readExact(uSerial &port, ReadMode mode, uint8_t *buf, size_t len)
+{
+    size_t got = 0;
+    while (got < len)
+    {
+        size_t n = readSome(port, mode, buf + got, len - got);
+        if (n == 0)
+            return false;
+        got += n;
+    }
+    return true;
+}
+
+static bool openPair(uSerial &master, uSerial &slave, ReadMode mode)
+{
+    if (!uSerial::openPty(master, slave, 4000000))
+        return false;
+    uint32_t spin = (mode == READ_SPIN) ? 200 : 0;
+    master.setBusyPoll(spin);
+    slave.setBusyPoll(spin);
+    return true;
+}
+
+struct Percentiles
+{
+    double p50_us;
+    double p99_us;
+    double p999_us;
+};
+
+static Percentiles percentiles(std::vector<uint64_t> &samples)
+{
+    Percentiles p = {0, 0, 0};
+    if (samples.empty())
+        return p;
+    std::sort(samples.begin(), samples.end());
+    size_t n = samples.size() - 1;
+    p.p50_us = samples[n / 2] / 1000.0;
+    p.p99_us = samples[n * 99 / 100] / 1000.0;
+    p.p999_us = samples[n * 999 / 1000] / 1000.0;
+    return p;
+}
+
+// Поток большими блоками slave -> master, MB/s
+static double benchBulk(ReadMode mode, size_t chunk, size_t total)
+{
+    uSerial master, slave;
+    if (!openPair(master, slave, mode))
+        return 0;
+
+    std::thread writer([&]()
+                       {
+        std::vector<uint8_t> out(chunk, 0x55);
+        for (size_t sent = 0; sent < total; sent += chunk)
+            if (!writeAll(slave, out.data(), std::min(chunk, total - sent)))
+                break; });
+
+    std::vector<uint8_t> in(chunk);
+    size_t received = 0;
+    uint64_t start = now_ns();
+    while (received < total)
+    {
+        size_t n = readSome(master, mode, in.data(), std::min(chunk, total - received));
+        if (n == 0)
+            break;
+        received += n;
+    }
+    uint64_t elapsed = now_ns() - start;
+    writer.join();
+
+    return elapsed ? (received / 1048576.0) / (elapsed / 1e9) : 0;
+}
+
+// Поток мелких сообщений фиксированной длины, сообщений в секунду
+static double benchMessages(ReadMode mode, size_t msg_len, size_t count)
+{
+    uSerial master, slave;
+    if (!openPair(master, slave, mode))
+        return 0;
+
+    std::thread writer([&]()
+                       {
+        std::vector<uint8_t> msg(msg_len, 0xA5);
+        for (size_t i = 0; i < count; i++)
+            if (!writeAll(slave, msg.data(), msg_len))
+                break; });
+
+    std::vector<uint8_t> in(msg_len);
+    size_t received = 0;
+    uint64_t start = now_ns();
+    while (received < count && readExact(master, mode, in.data(), msg_len))
+        received++;
+    uint64_t elapsed = now_ns() - start;
+    writer.join();
+
+    return elapsed ? received / (elapsed / 1e9) : 0;
+}
+
+// Пинг-понг с эхо-потоком на другой стороне пары
+static Percentiles benchRoundTrip(ReadMode mode, size_t msg_len, size_t iterations)
+{
+    uSerial master, slave;
+    Percentiles none = {0, 0, 0};
+    if (!openPair(master, slave, mode))
+        return none;
+
+    std::thread echo([&]()
+                     {
+        std::vector<uint8_t> buf(msg_len);
+        for (size_t i = 0; i < iterations; i++)
+        {
+            if (!readExact(slave, mode, buf.data(), msg_len) ||
+                !writeAll(slave, buf.data(), msg_len))
+                break;
+        } });
+
+    std::vector<uint8_t> msg(msg_len, 0x3C);
+    std::vector<uint64_t> samples;
+    samples.reserve(iterations);
+    for (size_t i = 0; i < iterations; i++)
+    {
+        uint64_t t0 = now_ns();
+        if (!writeAll(master, msg.data(), msg_len) ||
+            !readExact(master, mode, msg.data(), msg_len))
+            break;
+        samples.push_back(now_ns() - t0);
+    }
+    echo.join();
+
+    return percentiles(samples);
+}
+
+int main(int argc, char **argv)
+{
+    FILE *out = stdout;
+    if (argc > 1 && !(out = fopen(argv[1], "w")))
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    size_t total = (argc > 2 ? (size_t)atol(argv[2]) : 16) * 1048576;
+
+    static const ReadMode modes[] = {READ_POLL, READ_SPIN, READ_BYTES};
+    static const size_t chunks[] = {64, 512, 4096, 16384};
+    static const size_t msg_sizes[] = {8, 64, 256};
+
+    fprintf(out, "{\n  \"bulk\": [\n");
+    bool first = true;
+    for (ReadMode mode : modes)
+    {
+        // readBytes читает по байту, на полном объеме это минуты
+        size_t bytes = (mode == READ_BYTES) ? total / 16 : total;
+        for (size_t chunk : chunks)
+        {
+            fprintf(out, "%s    {\"mode\": \"%s\", \"chunk\": %zu, \"mb_per_s\": %.2f}",
+                    first ? "" : ",\n", modeName(mode), chunk, benchBulk(mode, chunk, bytes));
+            first = false;
+        }
+    }
+
+    fprintf(out, "\n  ],\n  \"messages\": [\n");
+    first = true;
+    for (ReadMode mode : modes)
+    {
+        for (size_t len : msg_sizes)
+        {
+            fprintf(out, "%s    {\"mode\": \"%s\", \"size\": %zu, \"msg_per_s\": %.0f}",
+                    first ? "" : ",\n", modeName(mode), len, benchMessages(mode, len, 50000));
+            first = false;
+        }
+    }
+
+    fprintf(out, "\n  ],\n  \"rtt\": [\n");
+    first = true;
+    for (ReadMode mode : modes)
+    {
+        for (size_t len : msg_sizes)
+        {
+            Percentiles p = benchRoundTrip(mode, len, 5000);
+            fprintf(out, "%s    {\"mode\": \"%s\", \"size\": %zu, "
+                         "\"p50_us\": %.2f, \"p99_us\": %.2f, \"p999_us\": %.2f}",
+                    first ? "" : ",\n", modeName(mode), len, p.p50_us, p.p99_us, p.p999_us);
+            first = false;
+        }
+    }
+    fprintf(out, "\n  ]\n}\n");
+
+    if (out != stdout)
+        fclose(out);
+    return 0;
+}
@@ -0,0 +1,263 @@
+#pragma once
+
+// Асинхронный слой на корутинах C++20 (опционально, только host-сборки).
+//
+//   uEventLoop loop;
+//   AsyncStream link(loop, serial);
+//
+//   uTask worker(AsyncStream &link)
+//   {
+//       while (link.isOpen())
+//       {
+//           sbu_t line = co_await link.readUntil('\n');
+//           co_await link.write(line.ptr, sbu_left(&line));
+//       }
+//   }
+//
+//   worker(link);
+//   loop.run();
+//
+// Один поток обслуживает любое число потоков через ::poll по их pollFd().
+// Ожидающие операции - объекты-awaiter'ы в кадре корутины, цикл держит
+// на них указатели в векторах с переиспользуемой емкостью, так что в
+// установившемся режиме операции ничего не выделяют. Кадр корутины
+// выделяется один раз на задачу.
+
+#if defined(__cpp_impl_coroutine) && !defined(ARDUINO) && !defined(FURI_OS)
+#include <coroutine>
+#include <exception>
+#include <vector>
+#include <poll.h>
+
+#include "stream.hpp"
+#include "buffered.hpp"
+
+class uEventLoop;
+
+// Ожидание готовности fd (и/или дедлайна). progress вызывается при
+// готовности fd и возвращает true, когда операция завершена. Если fd
+// сообщил POLLHUP/POLLERR/POLLNVAL, а progress не завершил операцию,
+// она завершается с failed
+struct uAsyncOp
+{
+    uEventLoop *loop = nullptr;
+    std::coroutine_handle<> handle;
+    int fd = -1;
+    short events = POLLIN;
+    bool has_deadline = false;
+    bool timed_out = false;
+    bool failed = false;
+    uint32_t deadline = 0;
+    bool (*progress)(uAsyncOp *op) = nullptr;
+    int pfd_index = -1;
+
+    void arm(uEventLoop *owner, std::coroutine_handle<> h, uint32_t timeout_ms);
+};
+
+// Задача верхнего уровня: стартует сразу, кадр освобождается по завершении
+struct uTask
+{
+    struct promise_type
+    {
+        uTask get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+class uEventLoop
+{
+public:
+    uEventLoop() : m_stop(false) {}
+
+    // Крутится, пока есть ожидающие операции или до stop()
+    void run();
+
+    // Одна итерация ::poll; false - ждать нечего
+    bool runOnce(int timeout_ms = -1);
+
+    void stop() { m_stop = true; }
+    size_t pending() const { return m_ops.size(); }
+
+    void add(uAsyncOp *op) { m_ops.push_back(op); }
+
+    // Реактор для push-модели: при готовности pollFd() потока вызывается
+    // stream.dispatch(), который раздает данные onData/onMessage
+    void watch(uStream &stream);
+    void unwatch(uStream &stream);
+
+    struct SleepOp : uAsyncOp
+    {
+        uint32_t ms;
+        bool await_ready() const { return ms == 0; }
+        void await_suspend(std::coroutine_handle<> h) { arm(owner, h, ms); }
+        void await_resume() const {}
+        uEventLoop *owner;
+    };
+
+    SleepOp sleep(uint32_t ms)
+    {
+        SleepOp op;
+        op.ms = ms;
+        op.owner = this;
+        return op;
+    }
+
+private:
+    struct WatchOp : uAsyncOp
+    {
+        uStream *stream = nullptr;
+
+        // Наблюдение бессрочное: завершается после unwatch() или закрытия
+        // потока. У закрытого потока fd может остаться читаемым навсегда
+        // (pipe уведомлений WebSocket), и цикл крутился бы вхолостую.
+        // Без fd поток опрашивается по времени и может быть еще не открыт
+        static bool step(uAsyncOp *op)
+        {
+            WatchOp *w = static_cast<WatchOp *>(op);
+            if (!w->stream)
+                return true;
+            w->stream->dispatch(0);
+            return closed(w);
+        }
+
+        static bool closed(const WatchOp *w)
+        {
+            return w->fd >= 0 && !w->stream->isOpen();
+        }
+    };
+
+    std::vector<std::unique_ptr<WatchOp>> m_watches;
+    std::vector<uAsyncOp *> m_ops;
+    std::vector<uAsyncOp *> m_scan;
+    std::vector<struct pollfd> m_pfds;
+    bool m_stop;
+};
+
+class AsyncStream
+{
+public:
+    AsyncStream(uEventLoop &loop, uStream &stream, size_t buffer_size = 512)
+        : m_loop(loop), m_stream(stream), m_reader(stream, buffer_size) {}
+
+    bool isOpen() const { return m_stream.isOpen() || m_reader.buffered() > 0; }
+    uStream &stream() { return m_stream; }
+
+    // Ровно length байт; меньше - только при закрытии потока или таймауте
+    struct ReadOp : uAsyncOp
+    {
+        AsyncStream *self;
+        uint8_t *buffer;
+        size_t length;
+        size_t done;
+        uint32_t timeout_ms;
+
+        static bool step(uAsyncOp *op)
+        {
+            ReadOp *r = static_cast<ReadOp *>(op);
+            while (r->done < r->length)
+            {
+                size_t n = r->self->m_reader.read(r->buffer + r->done, r->length - r->done);
+                if (n == 0 || n == (size_t)-1)
+                    break;
+                r->done += n;
+            }
+            return r->done == r->length || !r->self->m_stream.isOpen();
+        }
+
+        bool await_ready() { return step(this); }
+        void await_suspend(std::coroutine_handle<> h)
+        {
+            fd = self->m_stream.pollFd();
+            progress = &ReadOp::step;
+            arm(&self->m_loop, h, timeout_ms);
+        }
+        size_t await_resume() const { return done; }
+    };
+
+    // Данные до delim (без него); окно действительно до следующего чтения.
+    // Пустое окно (ptr == nullptr) - закрытие потока или таймаут
+    struct ReadUntilOp : uAsyncOp
+    {
+        AsyncStream *self;
+        uint8_t delim;
+        uint32_t timeout_ms;
+        sbu_t result;
+
+        static bool step(uAsyncOp *op)
+        {
+            ReadUntilOp *r = static_cast<ReadUntilOp *>(op);
+            r->result = r->self->m_reader.readUntil(r->delim, 0);
+            return r->result.ptr != nullptr || !r->self->m_stream.isOpen();
+        }
+
+        bool await_ready() { return step(this); }
+        void await_suspend(std::coroutine_handle<> h)
+        {
+            fd = self->m_stream.pollFd();
+            progress = &ReadUntilOp::step;
+            arm(&self->m_loop, h, timeout_ms);
+        }
+        sbu_t await_resume() const { return result; }
+    };
+
+    // Запись синхронная: fd uSerial и сокет WebSocket блокирующие, а
+    // буферы ядра поглощают типичные кадры; awaiter не приостанавливается
+    struct WriteOp
+    {
+        uStream *stream;
+        const uint8_t *buffer;
+        size_t length;
+        size_t done;
+
+        bool await_ready()
+        {
+            while (done < length)
+            {
+                size_t n = stream->write(buffer + done, length - done);
+                if (n == 0 || n == (size_t)-1)
+                    break;
+                done += n;
+            }
+            return true;
+        }
+        void await_suspend(std::coroutine_handle<>) {}
+        size_t await_resume() const { return done; }
+    };
+
+    ReadOp read(uint8_t *buffer, size_t length, uint32_t timeout_ms = 0)
+    {
+        ReadOp op;
+        op.self = this;
+        op.buffer = buffer;
+        op.length = length;
+        op.done = 0;
+        op.timeout_ms = timeout_ms;
+        return op;
+    }
+
+    ReadUntilOp readUntil(uint8_t delim, uint32_t timeout_ms = 0)
+    {
+        ReadUntilOp op;
+        op.self = this;
+        op.delim = delim;
+        op.timeout_ms = timeout_ms;
+        op.result.ptr = nullptr;
+        op.result.end = nullptr;
+        return op;
+    }
+
+    WriteOp write(const uint8_t *buffer, size_t length)
+    {
+        return WriteOp{&m_stream, buffer, length, 0};
+    }
+
+private:
+    uEventLoop &m_loop;
+    uStream &m_stream;
+    BufferedReader m_reader;
+};
+
+#endif // __cpp_impl_coroutine
@@ -0,0 +1,295 @@
+#pragma once
+
+#include "stream.hpp"
+
+// Статическая диспетчеризация потоков (CRTP).
+//
+// Парсеры, шаблонные по типу потока, через uStream платят косвенным
+// вызовом за каждый байт. BasicStream<Impl> дает тот же набор методов
+// без virtual: Impl реализует available/read/write, а readBytes,
+// readBuf, writeBuf, writeString и println собираются поверх них и
+// встраиваются компилятором.
+//
+//   DirectStream<uSerial> fast(port);     // байтовое чтение из inline-буфера
+//   SpanStream mem(rx, rx_len, tx, tx_len); // поток поверх памяти
+//   VirtualStream<SpanStream> erased(mem);  // обратно в uStream, если нужен
+//
+// Impl обязан предоставить:
+//   int     available();
+//   uint8_t read();
+//   size_t  read(uint8_t *buffer, size_t length);
+//   size_t  write(uint8_t byte);
+//   size_t  write(const uint8_t *buffer, size_t length);
+//   size_t  writev(const struct iovec *iov, int iovcnt); // необязательно
+//   void    flush();
+//   bool    poll(int timeout_ms);
+//   bool    isOpen() const;
+
+template <typename Impl>
+class BasicStream
+{
+public:
+    inline bool readBytes(uint8_t *buffer, size_t length, uint32_t timeout_ms = 1000)
+    {
+        if (!buffer)
+            return false;
+
+        size_t index = 0;
+        // millis(), а не micros(): разность 32-битных микросекунд
+        // переполняется через ~71 минуту и длинный таймаут не наступил бы
+        uint32_t start_time = millis();
+        while (index < length)
+        {
+            if (impl().available() > 0)
+            {
+                index += impl().read(buffer + index, length - index);
+            }
+            else
+            {
+                if (millis() - start_time >= timeout_ms)
+                    break;
+                impl().poll(1);
+            }
+        }
+        return index == length;
+    }
+
+    inline bool readBuf(sbu_t *dst)
+    {
+        if (!dst || !dst->ptr || dst->ptr >= dst->end)
+            return false;
+
+        int bytes_available = impl().available();
+        if (bytes_available <= 0)
+            return false;
+
+        size_t to_read = std::min(static_cast<size_t>(bytes_available), static_cast<size_t>(sbu_left(dst)));
+        size_t bytes_read = impl().read(dst->ptr, to_read);
+        if (bytes_read > 0)
+        {
+            sbu_skip(dst, (int)bytes_read);
+            return true;
+        }
+        return false;
+    }
+
+    inline bool writeBuf(sbu_t *src)
+    {
+        if (!src || !src->ptr || src->ptr >= src->end)
+            return false;
+
+        size_t bytes_to_write = sbu_left(src);
+        size_t bytes_written = impl().write(src->ptr, bytes_to_write);
+        if (bytes_written > 0)
+        {
+            sbu_skip(src, (int)bytes_written);
+            return bytes_written == bytes_to_write;
+        }
+        return false;
+    }
+
+    inline size_t writeString(const char *str)
+    {
+        if (!str)
+            return 0;
+        return impl().write(reinterpret_cast<const uint8_t *>(str), strlen(str));
+    }
+
+    // Impl может заменить своим writev (один системный вызов или фрейм)
+    inline size_t writev(const struct iovec *iov, int iovcnt)
+    {
+        size_t total = 0;
+        for (int i = 0; i < iovcnt; i++)
+        {
+            size_t len = iov[i].iov_len;
+            if (len == 0)
+                continue;
+            size_t written = impl().write(static_cast<const uint8_t *>(iov[i].iov_base), len);
+            total += written;
+            if (written != len)
+                break;
+        }
+        return total;
+    }
+
+    // Строка и перевод строки одной записью, как uStream::println
+    inline size_t println(const char *str = "")
+    {
+        static const char crlf[] = "\r\n";
+        struct iovec iov[2];
+        iov[0].iov_base = const_cast<char *>(str ? str : "");
+        iov[0].iov_len = str ? strlen(str) : 0;
+        iov[1].iov_base = const_cast<char *>(crlf);
+        iov[1].iov_len = 2;
+        return impl().writev(iov, 2);
+    }
+
+    inline bool isReadable()
+    {
+        return impl().isOpen() && impl().available() > 0;
+    }
+
+protected:
+    BasicStream() = default;
+
+private:
+    inline Impl &impl() { return *static_cast<Impl *>(this); }
+};
+
+// Обертка над конкретным транспортом (uSerial, WebSocket): вызовы идут
+// с квалификацией Transport:: и не проходят через vtable, а побайтовое
+// чтение обслуживается из inline-буфера на RX_SIZE байт
+template <typename Transport, size_t RX_SIZE = 256>
+class DirectStream : public BasicStream<DirectStream<Transport, RX_SIZE>>
+{
+public:
+    explicit DirectStream(Transport &transport) : m_transport(transport) {}
+
+    inline int available()
+    {
+        return (int)(m_rx_len - m_rx_pos) + m_transport.Transport::available();
+    }
+
+    inline uint8_t read()
+    {
+        if (m_rx_pos < m_rx_len || refill())
+            return m_rx[m_rx_pos++];
+        return static_cast<uint8_t>(-1);
+    }
+
+    inline size_t read(uint8_t *buffer, size_t length)
+    {
+        size_t buffered = m_rx_len - m_rx_pos;
+        if (buffered == 0)
+        {
+            // Ошибка транспорта ((size_t)-1) - это ноль прочитанных байт
+            size_t n = m_transport.Transport::read(buffer, length);
+            return n == (size_t)-1 ? 0 : n;
+        }
+
+        size_t n = std::min(length, buffered);
+        memcpy(buffer, m_rx + m_rx_pos, n);
+        m_rx_pos += n;
+        return n;
+    }
+
+    inline size_t write(uint8_t byte)
+    {
+        return m_transport.Transport::write(&byte, 1);
+    }
+
+    inline size_t write(const uint8_t *buffer, size_t length)
+    {
+        return m_transport.Transport::write(buffer, length);
+    }
+
+    inline size_t writev(const struct iovec *iov, int iovcnt)
+    {
+        return m_transport.Transport::writev(iov, iovcnt);
+    }
+
+    inline void flush() { m_transport.Transport::flush(); }
+
+    inline bool poll(int timeout_ms)
+    {
+        return m_rx_pos < m_rx_len || m_transport.Transport::poll(timeout_ms);
+    }
+
+    inline bool isOpen() const { return m_transport.Transport::isOpen(); }
+
+    Transport &transport() { return m_transport; }
+
+private:
+    Transport &m_transport;
+    uint8_t m_rx[RX_SIZE];
+    size_t m_rx_pos = 0;
+    size_t m_rx_len = 0;
+
+    // Медленный путь: одна пачка из транспорта на RX_SIZE байт
+    bool refill()
+    {
+        m_rx_pos = 0;
+        m_rx_len = 0;
+        if (m_transport.Transport::available() <= 0)
+            return false;
+        size_t n = m_transport.Transport::read(m_rx, RX_SIZE);
+        m_rx_len = (n == (size_t)-1) ? 0 : n;
+        return m_rx_len > 0;
+    }
+};
+
+// Поток поверх памяти: чтение из rx, запись в tx (любой может быть пустым)
+class SpanStream : public BasicStream<SpanStream>
+{
+public:
+    SpanStream(const uint8_t *rx, size_t rx_len, uint8_t *tx = nullptr, size_t tx_len = 0)
+        : m_rx(rx), m_rx_end(rx ? rx + rx_len : rx), m_tx(tx), m_tx_end(tx ? tx + tx_len : tx) {}
+
+    inline int available() { return (int)(m_rx_end - m_rx); }
+
+    inline uint8_t read()
+    {
+        return m_rx < m_rx_end ? *m_rx++ : static_cast<uint8_t>(-1);
+    }
+
+    inline size_t read(uint8_t *buffer, size_t length)
+    {
+        size_t n = std::min(length, (size_t)(m_rx_end - m_rx));
+        memcpy(buffer, m_rx, n);
+        m_rx += n;
+        return n;
+    }
+
+    inline size_t write(uint8_t byte)
+    {
+        if (m_tx >= m_tx_end)
+            return 0;
+        *m_tx++ = byte;
+        return 1;
+    }
+
+    inline size_t write(const uint8_t *buffer, size_t length)
+    {
+        size_t n = std::min(length, (size_t)(m_tx_end - m_tx));
+        memcpy(m_tx, buffer, n);
+        m_tx += n;
+        return n;
+    }
+
+    inline void flush() {}
+    inline bool poll(int) { return m_rx < m_rx_end; }
+    inline bool isOpen() const { return true; }
+
+    // Текущие позиции (сколько прочитано / куда писать дальше)
+    const uint8_t *rxPtr() const { return m_rx; }
+    uint8_t *txPtr() const { return m_tx; }
+
+private:
+    const uint8_t *m_rx;
+    const uint8_t *m_rx_end;
+    uint8_t *m_tx;
+    uint8_t *m_tx_end;
+};
+
+// Тонкая virtual-прослойка: любой BasicStream как uStream для кода,
+// которому нужно стирание типа
+template <typename Impl>
+class VirtualStream : public uStream
+{
+public:
+    explicit VirtualStream(Impl &impl) : m_impl(impl) {}
+
+    bool open(const char *, unsigned long) override { return m_impl.isOpen(); }
+    void close() override {}
+    int available() const override { return m_impl.available(); }
+    uint8_t read() override { return m_impl.read(); }
+    size_t read(uint8_t *buffer, size_t length) override { return m_impl.read(buffer, length); }
+    size_t write(uint8_t byte) override { return m_impl.write(byte); }
+    size_t write(const uint8_t *buffer, size_t length) override { return m_impl.write(buffer, length); }
+    void flush() override { m_impl.flush(); }
+    bool poll(int timeout_ms) override { return m_impl.poll(timeout_ms); }
+    bool isOpen() const override { return m_impl.isOpen(); }
+
+private:
+    Impl &m_impl;
+};
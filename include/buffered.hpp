@@ -0,0 +1,126 @@
+#pragma once
+
+#include "stream.hpp"
+
+// Буферизующие декораторы над любым uStream (uSerial, WebSocket, Arduino).
+// Сами являются uStream, поэтому их можно вкладывать и передавать туда же,
+// куда и исходный поток. Побайтовые read()/write() обслуживаются из буфера
+// и при вызове через конкретный тип встраиваются (классы final).
+
+class BufferedReader final : public uStream
+{
+public:
+    explicit BufferedReader(uStream &inner, size_t capacity = 512);
+
+    bool open(const char *port, unsigned long baudrate) override;
+    void close() override;
+    int available() const override;
+    size_t read(uint8_t *buffer, size_t length) override;
+    size_t write(uint8_t byte) override { return m_inner.write(byte); }
+    size_t write(const uint8_t *buffer, size_t length) override { return m_inner.write(buffer, length); }
+    // Напрямую: запись одним вызовом внутреннего потока (один кадр WebSocket)
+    size_t writev(const struct iovec *iov, int iovcnt) override { return m_inner.writev(iov, iovcnt); }
+    void flush() override { m_inner.flush(); }
+    bool poll(int timeout_ms) override;
+    bool isOpen() const override { return m_inner.isOpen(); }
+
+    uint8_t read() override
+    {
+        if (m_head < m_tail || fill() > 0)
+            return m_buf[m_head++];
+        return static_cast<uint8_t>(-1);
+    }
+
+    // Первые n байт без потребления; пустое окно, если столько еще нет
+    sbu_t peek(size_t n);
+
+    // Окно с данными до delim (сам delim потребляется, но в окно не входит).
+    // Ждет не дольше timeout_ms; пустое окно (ptr == nullptr) по таймауту.
+    // Если буфер заполнился без delim, возвращается весь буфер.
+    // Окно действительно до следующего чтения
+    sbu_t readUntil(uint8_t delim, uint32_t timeout_ms = 1000);
+
+    // readUntil('\n') с отброшенным '\r'
+    sbu_t readLine(uint32_t timeout_ms = 1000);
+
+    sbu_t acquireRead(size_t min = 1) override { return peek(min ? min : 1); }
+    void releaseRead(size_t n) override { m_head += std::min(n, m_tail - m_head); }
+
+    size_t buffered() const { return m_tail - m_head; }
+    uStream &inner() { return m_inner; }
+
+private:
+    uStream &m_inner;
+    std::vector<uint8_t> m_buf;
+    size_t m_head;
+    size_t m_tail;
+
+    // Дочитать из m_inner все доступное (не блокируясь), вернуть число байт
+    size_t fill();
+};
+
+class BufferedWriter final : public uStream
+{
+public:
+    // flush_threshold - отправлять, как только в буфере столько байт
+    // (0 - только при переполнении); flush_interval_ms - не держать
+    // данные дольше этого времени (0 - без ограничения, проверка в
+    // write/poll/tick)
+    explicit BufferedWriter(uStream &inner, size_t capacity = 512,
+                            size_t flush_threshold = 0, uint32_t flush_interval_ms = 0);
+    ~BufferedWriter();
+
+    bool open(const char *port, unsigned long baudrate) override;
+    void close() override;
+    int available() const override { return m_inner.available(); }
+    uint8_t read() override { return m_inner.read(); }
+    size_t read(uint8_t *buffer, size_t length) override { return m_inner.read(buffer, length); }
+    size_t readv(const struct iovec *iov, int iovcnt) override { return m_inner.readv(iov, iovcnt); }
+    size_t write(const uint8_t *buffer, size_t length) override;
+    size_t writev(const struct iovec *iov, int iovcnt) override;
+    void flush() override;
+    bool poll(int timeout_ms) override;
+    bool isOpen() const override { return m_inner.isOpen(); }
+
+    size_t write(uint8_t byte) override
+    {
+        if (m_len < m_buf.size())
+        {
+            if (m_len == 0)
+                m_first_ms = millis();
+            m_buf[m_len++] = byte;
+            autoFlush();
+            return 1;
+        }
+        return write(&byte, 1);
+    }
+
+    sbu_t acquireWrite(size_t min) override;
+    size_t commitWrite(size_t n) override;
+
+    // Отправить накопленное в m_inner без m_inner.flush()
+    bool flushBuffer();
+
+    // Проверка политики по времени для циклов, которые ничего не пишут
+    void tick() { autoFlush(); }
+
+    size_t buffered() const { return m_len; }
+    uStream &inner() { return m_inner; }
+
+private:
+    uStream &m_inner;
+    std::vector<uint8_t> m_buf;
+    size_t m_len;
+    size_t m_flush_threshold;
+    uint32_t m_flush_interval_ms;
+    uint32_t m_first_ms;
+
+    inline void autoFlush()
+    {
+        if (m_len == 0)
+            return;
+        if ((m_flush_threshold && m_len >= m_flush_threshold) ||
+            (m_flush_interval_ms && millis() - m_first_ms >= m_flush_interval_ms))
+            flushBuffer();
+    }
+};
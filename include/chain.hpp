@@ -0,0 +1,91 @@
+#pragma once
+
+// Цепочка буферов (iovec rope) для сборки кадра без копирования:
+// заголовки и контрольные суммы пишутся во встроенную память цепочки,
+// полезная нагрузка только упоминается ссылкой и уходит в writev как есть.
+//
+//   uChain frame;
+//   sbu_t hdr = frame.reserve(4);
+//   sbu_write_u16le(&hdr, MSG_FIRMWARE);
+//   sbu_write_u16le(&hdr, (uint16_t)block_len);
+//   frame.ref(block, block_len);              // без копии
+//   uint16_t crc = frame.crc16(&ctx, 0xFFFF);
+//   sbu_t tail = frame.reserve(2);
+//   sbu_write_u16le(&tail, crc);
+//   frame.writeTo(stream);                    // один writev
+//
+// Память из ref() должна жить до отправки. Указатели на встроенную
+// память стабильны, поэтому цепочку нельзя копировать и перемещать.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <memory>
+#include <vector>
+#include "crc.h"
+#include "sbu.h"
+#include "stream.hpp"
+
+#ifndef UCHAIN_INLINE
+#define UCHAIN_INLINE 128
+#endif
+
+// Сколько сегментов отдавать в один writev (IOV_MAX в Linux - 1024)
+#ifndef UCHAIN_IOV_MAX
+#define UCHAIN_IOV_MAX 1024
+#endif
+
+class uChain
+{
+public:
+    uChain() : m_used(0), m_size(0), m_chunk_used(0), m_chunk_size(0) {}
+    uChain(const uChain &) = delete;
+    uChain &operator=(const uChain &) = delete;
+
+    // Окно на n байт во встроенной памяти, добавленное в конец цепочки.
+    // Соседние окна сливаются в один сегмент
+    sbu_t reserve(size_t n);
+
+    // Скопировать мелкие данные во встроенную память
+    void copy(const void *data, size_t len);
+
+    // Сослаться на данные без копирования
+    void ref(const void *data, size_t len);
+
+    void clear();
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    int count() const { return (int)m_iov.size(); }
+    const struct iovec *iov() const { return m_iov.data(); }
+
+    // Контрольные суммы по всем сегментам подряд
+    uint8_t crc8(const crc8_ctx_t *ctx, uint8_t crc = 0) const;
+    uint16_t crc16(const crc16_ctx_t *ctx, uint16_t crc = 0) const;
+
+    // Обход сегментов: fn(const uint8_t *ptr, size_t len)
+    template <typename F>
+    void forEach(F &&fn) const
+    {
+        for (const struct iovec &v : m_iov)
+            fn(static_cast<const uint8_t *>(v.iov_base), v.iov_len);
+    }
+
+    // Склеить в непрерывный буфер (не больше capacity байт)
+    size_t copyTo(uint8_t *dst, size_t capacity) const;
+
+    // writev пачками по UCHAIN_IOV_MAX сегментов; число отправленных байт
+    size_t writeTo(uStream &stream) const;
+
+private:
+    uint8_t m_inline[UCHAIN_INLINE];
+    size_t m_used;
+    size_t m_size;
+    std::vector<struct iovec> m_iov;
+    // Встроенная память кончилась - блоки в куче, адреса не меняются
+    std::vector<std::unique_ptr<uint8_t[]>> m_chunks;
+    size_t m_chunk_used;
+    size_t m_chunk_size;
+
+    uint8_t *allocate(size_t n);
+    void append(const uint8_t *ptr, size_t len, bool owned);
+};
@@ -0,0 +1,145 @@
+#pragma once
+
+// Монотонные часы с наносекундным разрешением для host-сборок.
+//
+// nowNs() - время, на котором работают таймауты библиотеки (через
+// elapsedNs() - millis(), micros(), readBytes; отметки readPacket). Его можно подменить
+// виртуальными часами для детерминированных тестов и симуляций:
+//
+//   uClock::useVirtual();
+//   uClock::advance(1500000);   // +1.5 мс
+//
+// realNs() - всегда аппаратное время: бюджеты активного ожидания,
+// статистика и трасса не должны зависеть от подмены.
+// Источник по умолчанию - CLOCK_MONOTONIC_RAW (vDSO, без коррекции NTP),
+// на x86-64 с инвариантным TSC можно переключиться на rdtsc: useTsc().
+
+#if !defined(ARDUINO) && !defined(FURI_OS)
+#include <stdint.h>
+#include <time.h>
+#include <atomic>
+
+#if defined(__x86_64__)
+#include <x86intrin.h>
+#define UCLOCK_HAS_TSC 1
+#else
+#define UCLOCK_HAS_TSC 0
+#endif
+
+#ifdef CLOCK_MONOTONIC_RAW
+#define UCLOCK_RAW_ID CLOCK_MONOTONIC_RAW
+#else
+#define UCLOCK_RAW_ID CLOCK_MONOTONIC
+#endif
+
+class uClock
+{
+public:
+    enum Source
+    {
+        SOURCE_MONOTONIC = 0,
+        SOURCE_TSC,
+        SOURCE_VIRTUAL,
+    };
+
+    static inline uint64_t nowNs()
+    {
+        if (s_virtual.load(std::memory_order_relaxed))
+            return s_virtual_ns.load(std::memory_order_acquire);
+        return realNs();
+    }
+
+    static inline uint64_t nowUs() { return nowNs() / 1000ULL; }
+    static inline uint64_t nowMs() { return nowNs() / 1000000ULL; }
+
+    // Время от первого обращения к часам процесса - основа millis()/micros(),
+    // которые и до uClock отсчитывались от старта, а не от загрузки системы
+    // (иначе 32-битный millis() переполняется через 49.7 суток аптайма
+    // машины, а не процесса). Виртуальные часы уже относительны и идут как есть
+    static inline uint64_t elapsedNs()
+    {
+        if (s_virtual.load(std::memory_order_relaxed))
+            return s_virtual_ns.load(std::memory_order_acquire);
+        uint64_t origin = originNs();
+        uint64_t now = realNs();
+        // TSC калиброван по CLOCK_MONOTONIC_RAW, но может отставать от него
+        // на наносекунды - не даем разности уйти в переполнение
+        return now > origin ? now - origin : 0;
+    }
+
+    static inline uint64_t realNs()
+    {
+#if UCLOCK_HAS_TSC
+        if (s_tsc.load(std::memory_order_acquire))
+        {
+            // Seqlock: useTsc() может перекалибровать параметры на ходу,
+            // смешивать base от одной калибровки с mult от другой нельзя
+            uint64_t base, base_ns, mult;
+            uint32_t seq;
+            do
+            {
+                seq = s_tsc_seq.load(std::memory_order_acquire);
+                base = s_tsc_base.load(std::memory_order_relaxed);
+                base_ns = s_tsc_base_ns.load(std::memory_order_relaxed);
+                mult = s_tsc_mult.load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+            } while ((seq & 1U) || seq != s_tsc_seq.load(std::memory_order_relaxed));
+            uint64_t cycles = __rdtsc() - base;
+            return base_ns + (uint64_t)(((unsigned __int128)cycles * mult) >> 32);
+        }
+#endif
+        return monotonicNs();
+    }
+
+    static inline uint64_t monotonicNs()
+    {
+        struct timespec ts;
+        clock_gettime(UCLOCK_RAW_ID, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+    }
+
+    static Source source()
+    {
+        if (s_virtual.load(std::memory_order_relaxed))
+            return SOURCE_VIRTUAL;
+        return s_tsc.load(std::memory_order_relaxed) ? SOURCE_TSC : SOURCE_MONOTONIC;
+    }
+
+    // Калибровка TSC по CLOCK_MONOTONIC_RAW за calibrate_ms; false, если
+    // TSC нет или он не инвариантный (тогда остается clock_gettime)
+    static bool useTsc(uint32_t calibrate_ms = 10);
+
+    // Назад на clock_gettime и/или с виртуальных часов на реальные
+    static void useMonotonic()
+    {
+        s_tsc.store(false, std::memory_order_release);
+        s_virtual.store(false, std::memory_order_release);
+    }
+
+    // Виртуальные часы стоят, пока их не двигают advance()/set()
+    static void useVirtual(uint64_t start_ns = 0)
+    {
+        s_virtual_ns.store(start_ns, std::memory_order_release);
+        s_virtual.store(true, std::memory_order_release);
+    }
+
+    static void advance(uint64_t ns) { s_virtual_ns.fetch_add(ns, std::memory_order_acq_rel); }
+    static void set(uint64_t ns) { s_virtual_ns.store(ns, std::memory_order_release); }
+
+private:
+    static inline uint64_t originNs()
+    {
+        static const uint64_t origin = monotonicNs();
+        return origin;
+    }
+
+    static inline std::atomic<bool> s_virtual{false};
+    static inline std::atomic<uint64_t> s_virtual_ns{0};
+    static inline std::atomic<bool> s_tsc{false};
+    static inline std::atomic<uint32_t> s_tsc_seq{0}; // нечетный - идет запись
+    static inline std::atomic<uint64_t> s_tsc_base{0};
+    static inline std::atomic<uint64_t> s_tsc_base_ns{0};
+    static inline std::atomic<uint64_t> s_tsc_mult{0}; // нс на такт, фиксированная точка 32.32
+};
+
+#endif // !ARDUINO && !FURI_OS
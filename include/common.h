@@ -33,7 +33,20 @@
 #define ICACHE_RAM_ATTR
 #endif
 
-#ifndef ARDUINO
+#if !defined(ARDUINO) && !defined(FURI_OS)
+#include "clock.hpp"
+
+// Как и на Arduino, отсчет от старта процесса (первого обращения к часам)
+static inline uint32_t millis()
+{
+    return (uint32_t)(uClock::elapsedNs() / 1000000ULL);
+}
+
+static inline uint32_t micros()
+{
+    return (uint32_t)(uClock::elapsedNs() / 1000ULL);
+}
+#elif !defined(ARDUINO)
 #include <chrono>
 
 static inline uint32_t millis()
@@ -42,4 +55,11 @@ static inline uint32_t millis()
     static auto start = steady_clock::now();
     return duration_cast<milliseconds>(steady_clock::now() - start).count();
 }
-#endif
\ No newline at end of file
+
+static inline uint32_t micros()
+{
+    using namespace std::chrono;
+    static auto start = steady_clock::now();
+    return duration_cast<microseconds>(steady_clock::now() - start).count();
+}
+#endif
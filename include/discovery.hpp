@@ -0,0 +1,53 @@
+#pragma once
+
+#include "serial.hpp"
+
+#if !defined(ARDUINO) && !defined(FURI_OS)
+#include <string>
+#include <vector>
+#include <mutex>
+
+struct uSerialPortInfo
+{
+    std::string device;       // /dev/ttyUSB0
+    std::string name;         // ttyUSB0
+    std::string driver;       // ftdi_sio, cp210x, cdc_acm ...
+    std::string by_id;        // /dev/serial/by-id/..., если udev его создал
+    uint16_t vid = 0;         // 0 - не USB
+    uint16_t pid = 0;
+    std::string serial;
+    std::string manufacturer;
+    std::string product;
+};
+
+// Перечисление последовательных портов по sysfs без их открытия.
+// Список кешируется и перечитывается только после uevent от udev (без udev - от ядра)
+// (подключение/отключение устройства), поэтому повторные вызовы почти бесплатны
+class uSerialDiscovery
+{
+public:
+    // Копия актуального списка; refresh - перечитать sysfs принудительно
+    static std::vector<uSerialPortInfo> ports(bool refresh = false);
+
+    // Поиск по стабильному идентификатору:
+    //   "/dev/..."              - путь как есть
+    //   "vid:pid" / "vid:pid:serial" (hex) - USB-устройство
+    //   "serial"                - серийный номер
+    //   имя из /dev/serial/by-id или имя tty (ttyUSB0)
+    static bool find(const char *id, uSerialPortInfo &info);
+
+    static bool open(uSerial &port, const char *id, unsigned long baudrate);
+
+private:
+    static std::mutex s_mutex;
+    static std::vector<uSerialPortInfo> s_ports;
+    static bool s_valid;
+    static int s_uevent_fd;
+    static struct timespec s_dev_mtime;
+
+    static bool changed();
+    static void scan(std::vector<uSerialPortInfo> &ports);
+    static bool readPortInfo(const std::string &name, uSerialPortInfo &info);
+    static bool matches(const uSerialPortInfo &info, const char *id);
+};
+#endif // !ARDUINO && !FURI_OS
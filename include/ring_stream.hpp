@@ -0,0 +1,150 @@
+#pragma once
+
+// Потоки поверх кольцевых буферов в общей памяти (только host-сборки).
+//
+//   MemoryStream a, b;
+//   MemoryStream::pair(a, b);          // петля в пределах процесса
+//
+//   ShmStream bridge, logger;           // два процесса
+//   bridge.create("/bridge-log");      // процесс 1
+//   logger.open("/bridge-log", 0);     // процесс 2
+//
+// В каждую сторону - SPSC-кольцо: писатель двигает head, читатель tail,
+// без блокировок. Страницы данных отображены дважды подряд, поэтому
+// любое окно до capacity байт непрерывно: acquireRead/acquireWrite
+// отдают указатели прямо в кольцо, memcpy никогда не режется на две части.
+// Ожидание - futex на счетчике в общей памяти, системный вызов только
+// когда другая сторона действительно спит.
+
+#if !defined(ARDUINO) && !defined(FURI_OS)
+#include <atomic>
+#include <string>
+#include "stream.hpp"
+
+#define URING_MAGIC "USTRING1"
+#define URING_VERSION 2
+// Шаг, с которым бесконечное ожидание проверяет, жив ли процесс другой стороны
+#define URING_LIVENESS_MS 100
+
+// Управляющий блок одного направления; лежит в общей памяти
+struct uRingControl
+{
+    alignas(64) std::atomic<uint64_t> head; // всего записано
+    alignas(64) std::atomic<uint64_t> tail; // всего прочитано
+    alignas(64) std::atomic<uint32_t> data_seq;  // futex: пришли данные
+    std::atomic<uint32_t> space_seq;             // futex: освободилось место
+    std::atomic<uint32_t> readers_waiting;
+    std::atomic<uint32_t> writers_waiting;
+    std::atomic<uint32_t> writer_closed;
+    std::atomic<uint32_t> reader_closed;
+};
+
+struct uRingHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t capacity; // на одно направление, степень двойки, кратна странице
+    std::atomic<uint32_t> ready;
+    std::atomic<uint32_t> attached; // вторая сторона занята
+    std::atomic<int32_t> pid[2];    // процессы сторон, для проверки живости
+    uRingControl ring[2];
+};
+
+// Общая часть: конец дуплексного канала в отображенной области
+class RingStream : public uStream
+{
+public:
+    RingStream();
+    ~RingStream();
+
+    void close() override;
+    int available() const override;
+    uint8_t read() override;
+    size_t read(uint8_t *buffer, size_t length) override;
+    size_t write(uint8_t byte) override;
+    size_t write(const uint8_t *buffer, size_t length) override;
+    size_t writev(const struct iovec *iov, int iovcnt) override;
+    size_t readv(const struct iovec *iov, int iovcnt) override;
+    // Окна указывают прямо в кольцо. acquireWrite ждет, пока освободится
+    // min байт (или другая сторона закроется)
+    sbu_t acquireRead(size_t min = 1) override;
+    void releaseRead(size_t n) override;
+    sbu_t acquireWrite(size_t min) override;
+    size_t commitWrite(size_t n) override;
+    // Данные видны другой стороне сразу после write
+    void flush() override {}
+    bool poll(int timeout_ms) override;
+    bool isOpen() const override;
+
+    size_t capacity() const { return m_mask + 1; }
+
+    // Сколько write/acquireWrite ждут места в кольце: -1 - пока читатель
+    // не закроется или не умрет (по умолчанию), 0 - не ждать. По таймауту
+    // write возвращает записанное к этому моменту
+    void setWriteTimeout(int timeout_ms) { m_write_timeout_ms = timeout_ms; }
+
+protected:
+    uRingHeader *m_header;
+    size_t m_map_size;
+    uRingControl *m_rx;
+    uRingControl *m_tx;
+    uint8_t *m_rx_data;
+    uint8_t *m_tx_data;
+    size_t m_mask;
+    // eventfd для pollFd() (только MemoryStream): свой и копия чужого
+    int m_event_fd;
+    int m_peer_event_fd;
+    int m_write_timeout_ms;
+
+    // Инициализировать заголовок в новом объекте памяти fd
+    static bool format(int fd, size_t capacity);
+    // Отобразить fd и занять сторону side (0 - создатель, 1 - подключившийся)
+    bool attach(int fd, int side);
+
+private:
+    size_t push(const struct iovec *iov, int iovcnt);
+    void consume(size_t n);
+    void publish(uint64_t head, size_t n);
+    bool waitData(int timeout_ms);
+    bool waitSpace(size_t n, int timeout_ms);
+    // false, если процесс другой стороны завершился, не закрыв канал
+    bool peerAlive() const;
+    void clearEvent();
+};
+
+class MemoryStream final : public RingStream
+{
+public:
+    // Пара концов одного канала в пределах процесса. capacity округляется
+    // вверх до степени двойки и размера страницы
+    static bool pair(MemoryStream &a, MemoryStream &b, size_t capacity = 65536);
+
+    // Открывается только через pair()
+    bool open(const char *port, unsigned long baudrate) override;
+    int pollFd() const override { return m_event_fd; }
+};
+
+// pollFd() нет: eventfd не передать в чужой процесс через имя объекта,
+// цикл событий опрашивает такой поток по времени. Канал одноразовый:
+// после close() любой из сторон его создают заново
+class ShmStream final : public RingStream
+{
+public:
+    ShmStream() : m_owner(false) {}
+    ~ShmStream();
+
+    // Создать объект shm_open(name) и занять первую сторону. Если имя уже
+    // занято, false с errno == EEXIST; replace удаляет прежний объект
+    bool create(const char *name, size_t capacity = 1 << 20, bool replace = false);
+    // Подключиться к объекту, созданному другим процессом через create().
+    // baudrate не используется
+    bool open(const char *name, unsigned long baudrate) override;
+    // Создатель удаляет имя объекта; уже подключенные стороны работают дальше
+    void close() override;
+
+private:
+    std::string m_name;
+    bool m_owner;
+};
+
+#endif // !ARDUINO && !FURI_OS
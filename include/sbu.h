@@ -48,8 +48,8 @@ typedef struct sbu_s {
 extern "C" { 
 #endif
 
-// init
-sbu_t *sbu_init(sbu_t *sbu, uint8_t *ptr, uint8_t *end);
+// sbu_init, sbu_left/sbu_skip, поля sbu_write_*/sbu_read_* и их _safe-варианты
+// объявлены ниже, после быстрого пути (static inline или внешние символы)
 
 // low-level access
 uint8_t *sbu_ptr(sbu_t *buf);
@@ -57,68 +57,1009 @@ const uint8_t *sbu_const_ptr(const sbu_t *buf);
 
 // utils
 int  sbu_size(sbu_t *buf);                        // полный
-int  sbu_left(sbu_t *buf);                        // осталось 
-void sbu_skip(sbu_t *buf, int size);              // сдвинуть
 void sbu_fill(sbu_t *dst, uint8_t data, int len); // заполнить 
 void sbu_switch_to_reader(sbu_t *buf, uint8_t *base);
 
-// sbu_write basic
-void sbu_write_data      (sbu_t *dst, const void *data, int len);
-bool sbu_write_data_safe (sbu_t *dst, const void *data, int len);
-void sbu_write_u8        (sbu_t *dst, uint8_t val);
-void sbu_write_i8        (sbu_t *dst, int8_t val);
-
-// sbu_write advanced
-void sbu_write_u16le(sbu_t *dst, uint16_t val);
-void sbu_write_u16be(sbu_t *dst, uint16_t val);
-// void sbu_write_u24le(sbu_t *dst, uint32_t val); feature
-// void sbu_write_u24be(sbu_t *dst, uint32_t val); feature
-void sbu_write_u32le(sbu_t *dst, uint32_t val);
-void sbu_write_u32be(sbu_t *dst, uint32_t val);
-
 // sbu_write_string
 void sbu_write_string     (sbu_t *dst, const char *string);
 void sbu_write_string_pscl(sbu_t *dst, const char *string);
 void sbu_write_string_zero(sbu_t *dst, const char *string);
 
+// sbu_read varint: пакетное чтение до count значений; возвращает, сколько прочитано
+// (меньше count - данные кончились или значение испорчено)
+int sbu_read_uvarint_batch(sbu_t *src, uint64_t *vals, int count);
+int sbu_read_svarint_batch(sbu_t *src, int64_t *vals, int count);
+
+// Массивы: count элементов подряд. Совпадает порядок байт с хостом -
+// memcpy, иначе перестановка векторными командами (AVX2/SSSE3/SSE2/NEON)
+#define SBU_ARRAY_DECL(name, type)                                              \
+    void sbu_write_##name##_array     (sbu_t *dst, const type *vals, int count); \
+    bool sbu_write_##name##_array_safe(sbu_t *dst, const type *vals, int count); \
+    void sbu_read_##name##_array      (sbu_t *src, type *vals, int count);       \
+    bool sbu_read_##name##_array_safe (sbu_t *src, type *vals, int count);
+
+SBU_ARRAY_DECL(u16le, uint16_t)
+SBU_ARRAY_DECL(u16be, uint16_t)
+SBU_ARRAY_DECL(i16le, int16_t)
+SBU_ARRAY_DECL(i16be, int16_t)
+SBU_ARRAY_DECL(u32le, uint32_t)
+SBU_ARRAY_DECL(u32be, uint32_t)
+SBU_ARRAY_DECL(i32le, int32_t)
+SBU_ARRAY_DECL(i32be, int32_t)
+SBU_ARRAY_DECL(u64le, uint64_t)
+SBU_ARRAY_DECL(u64be, uint64_t)
+SBU_ARRAY_DECL(i64le, int64_t)
+SBU_ARRAY_DECL(i64be, int64_t)
+SBU_ARRAY_DECL(f32le, float)
+SBU_ARRAY_DECL(f32be, float)
+SBU_ARRAY_DECL(f64le, double)
+SBU_ARRAY_DECL(f64be, double)
+
+// Копирование с перестановкой байт внутри каждого слова width (2, 4, 8);
+// bytes кратно width
+void sbu_bswap_copy(void *dst, const void *src, size_t bytes, int width);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+// Быстрый путь: static inline реализации с невыровненным доступом через
+// memcpy и перестановкой байт встроенными функциями компилятора.
+// Публичные имена в конце файла - обертки над ними, внешние символы
+// из sbu.c остаются (адрес функции, вызовы из других языков).
+// SBU_NO_INLINE перед #include "sbu.h" - обычные вызовы функций.
+
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define SBU_BIG_ENDIAN 1
+#else
+#define SBU_BIG_ENDIAN 0
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SBU_BSWAP16(x) __builtin_bswap16(x)
+#define SBU_BSWAP32(x) __builtin_bswap32(x)
+#define SBU_BSWAP64(x) __builtin_bswap64(x)
+#else
+#define SBU_BSWAP16(x) ((uint16_t)(((uint16_t)(x) >> 8) | ((uint16_t)(x) << 8)))
+#define SBU_BSWAP32(x) ((((uint32_t)(x) & 0x000000FFu) << 24) | (((uint32_t)(x) & 0x0000FF00u) << 8) | \
+                        (((uint32_t)(x) & 0x00FF0000u) >> 8) | (((uint32_t)(x) & 0xFF000000u) >> 24))
+#define SBU_BSWAP64(x) (((uint64_t)SBU_BSWAP32((uint32_t)(x)) << 32) | SBU_BSWAP32((uint32_t)((uint64_t)(x) >> 32)))
+#endif
+
+#if SBU_BIG_ENDIAN
+#define SBU_TO_LE16(x) SBU_BSWAP16(x)
+#define SBU_TO_LE32(x) SBU_BSWAP32(x)
+#define SBU_TO_LE64(x) SBU_BSWAP64(x)
+#define SBU_TO_BE16(x) (x)
+#define SBU_TO_BE32(x) (x)
+#define SBU_TO_BE64(x) (x)
+#else
+#define SBU_TO_LE16(x) (x)
+#define SBU_TO_LE32(x) (x)
+#define SBU_TO_LE64(x) (x)
+#define SBU_TO_BE16(x) SBU_BSWAP16(x)
+#define SBU_TO_BE32(x) SBU_BSWAP32(x)
+#define SBU_TO_BE64(x) SBU_BSWAP64(x)
+#endif
+
+static inline uint16_t sbu_load16(const uint8_t *p) { uint16_t v; memcpy(&v, p, 2); return v; }
+static inline uint32_t sbu_load32(const uint8_t *p) { uint32_t v; memcpy(&v, p, 4); return v; }
+static inline uint64_t sbu_load64(const uint8_t *p) { uint64_t v; memcpy(&v, p, 8); return v; }
+static inline void sbu_store16(uint8_t *p, uint16_t v) { memcpy(p, &v, 2); }
+static inline void sbu_store32(uint8_t *p, uint32_t v) { memcpy(p, &v, 4); }
+static inline void sbu_store64(uint8_t *p, uint64_t v) { memcpy(p, &v, 8); }
+
+static inline sbu_t *sbu_fast_init(sbu_t *sbu, uint8_t *ptr, uint8_t *end)
+{
+    sbu->ptr = ptr;
+    sbu->end = end;
+    return sbu;
+}
+
+static inline int sbu_fast_left(sbu_t *buf)
+{
+    if (!buf || !buf->ptr || !buf->end || buf->end < buf->ptr) return 0;
+    return (int)(buf->end - buf->ptr);
+}
+
+static inline void sbu_fast_skip(sbu_t *buf, int size)
+{
+    if (!buf || size <= 0) return;
+    buf->ptr += size;
+}
+
+static inline void sbu_fast_write_data(sbu_t *dst, const void *data, int len)
+{
+    if (!dst || !data || len <= 0) return;
+    memcpy(dst->ptr, data, (size_t)len);
+    dst->ptr += len;
+}
+
+static inline void sbu_fast_read_data(sbu_t *src, void *data, int len)
+{
+    if (!src || len <= 0) return;
+    if (data) memcpy(data, src->ptr, (size_t)len);
+    src->ptr += len;
+}
+
+static inline void sbu_fast_write_u8(sbu_t *dst, uint8_t val) { *dst->ptr++ = val; }
+static inline void sbu_fast_write_i8(sbu_t *dst, int8_t val) { *dst->ptr++ = (uint8_t)val; }
+
+static inline void sbu_fast_write_u16le(sbu_t *dst, uint16_t val) { sbu_store16(dst->ptr, SBU_TO_LE16(val)); dst->ptr += 2; }
+static inline void sbu_fast_write_u16be(sbu_t *dst, uint16_t val) { sbu_store16(dst->ptr, SBU_TO_BE16(val)); dst->ptr += 2; }
+static inline void sbu_fast_write_u32le(sbu_t *dst, uint32_t val) { sbu_store32(dst->ptr, SBU_TO_LE32(val)); dst->ptr += 4; }
+static inline void sbu_fast_write_u32be(sbu_t *dst, uint32_t val) { sbu_store32(dst->ptr, SBU_TO_BE32(val)); dst->ptr += 4; }
+static inline void sbu_fast_write_u64le(sbu_t *dst, uint64_t val) { sbu_store64(dst->ptr, SBU_TO_LE64(val)); dst->ptr += 8; }
+static inline void sbu_fast_write_u64be(sbu_t *dst, uint64_t val) { sbu_store64(dst->ptr, SBU_TO_BE64(val)); dst->ptr += 8; }
+
+static inline void sbu_fast_write_u24le(sbu_t *dst, uint32_t val)
+{
+    dst->ptr[0] = (uint8_t)val;
+    dst->ptr[1] = (uint8_t)(val >> 8);
+    dst->ptr[2] = (uint8_t)(val >> 16);
+    dst->ptr += 3;
+}
+
+static inline void sbu_fast_write_u24be(sbu_t *dst, uint32_t val)
+{
+    dst->ptr[0] = (uint8_t)(val >> 16);
+    dst->ptr[1] = (uint8_t)(val >> 8);
+    dst->ptr[2] = (uint8_t)val;
+    dst->ptr += 3;
+}
+
+// IEEE 754: битовое представление через memcpy, без каламбура через union
+static inline uint32_t sbu_f32_bits(float val) { uint32_t v; memcpy(&v, &val, 4); return v; }
+static inline uint64_t sbu_f64_bits(double val) { uint64_t v; memcpy(&v, &val, 8); return v; }
+static inline float sbu_bits_f32(uint32_t v) { float val; memcpy(&val, &v, 4); return val; }
+static inline double sbu_bits_f64(uint64_t v) { double val; memcpy(&val, &v, 8); return val; }
+
+static inline void sbu_fast_write_f32le(sbu_t *dst, float val) { sbu_fast_write_u32le(dst, sbu_f32_bits(val)); }
+static inline void sbu_fast_write_f32be(sbu_t *dst, float val) { sbu_fast_write_u32be(dst, sbu_f32_bits(val)); }
+static inline void sbu_fast_write_f64le(sbu_t *dst, double val) { sbu_fast_write_u64le(dst, sbu_f64_bits(val)); }
+static inline void sbu_fast_write_f64be(sbu_t *dst, double val) { sbu_fast_write_u64be(dst, sbu_f64_bits(val)); }
+
+static inline uint8_t sbu_fast_read_u8(sbu_t *src) { return *src->ptr++; }
+static inline int8_t sbu_fast_read_i8(sbu_t *src) { return (int8_t)(*src->ptr++); }
+
+static inline uint16_t sbu_fast_read_u16le(sbu_t *src) { uint16_t v = sbu_load16(src->ptr); src->ptr += 2; return SBU_TO_LE16(v); }
+static inline uint16_t sbu_fast_read_u16be(sbu_t *src) { uint16_t v = sbu_load16(src->ptr); src->ptr += 2; return SBU_TO_BE16(v); }
+static inline uint32_t sbu_fast_read_u32le(sbu_t *src) { uint32_t v = sbu_load32(src->ptr); src->ptr += 4; return SBU_TO_LE32(v); }
+static inline uint32_t sbu_fast_read_u32be(sbu_t *src) { uint32_t v = sbu_load32(src->ptr); src->ptr += 4; return SBU_TO_BE32(v); }
+static inline int16_t sbu_fast_read_i16le(sbu_t *src) { return (int16_t)sbu_fast_read_u16le(src); }
+static inline int16_t sbu_fast_read_i16be(sbu_t *src) { return (int16_t)sbu_fast_read_u16be(src); }
+static inline int32_t sbu_fast_read_i32le(sbu_t *src) { return (int32_t)sbu_fast_read_u32le(src); }
+static inline int32_t sbu_fast_read_i32be(sbu_t *src) { return (int32_t)sbu_fast_read_u32be(src); }
+static inline uint64_t sbu_fast_read_u64le(sbu_t *src) { uint64_t v = sbu_load64(src->ptr); src->ptr += 8; return SBU_TO_LE64(v); }
+static inline uint64_t sbu_fast_read_u64be(sbu_t *src) { uint64_t v = sbu_load64(src->ptr); src->ptr += 8; return SBU_TO_BE64(v); }
+static inline int64_t sbu_fast_read_i64le(sbu_t *src) { return (int64_t)sbu_fast_read_u64le(src); }
+static inline int64_t sbu_fast_read_i64be(sbu_t *src) { return (int64_t)sbu_fast_read_u64be(src); }
+
+static inline uint32_t sbu_fast_read_u24le(sbu_t *src)
+{
+    const uint8_t *p = src->ptr;
+    src->ptr += 3;
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+}
+
+static inline uint32_t sbu_fast_read_u24be(sbu_t *src)
+{
+    const uint8_t *p = src->ptr;
+    src->ptr += 3;
+    return ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | (uint32_t)p[2];
+}
+
+// Расширение знака 24 -> 32 бит без сдвига отрицательных чисел
+static inline int32_t sbu_sext24(uint32_t v) { return (int32_t)((v ^ 0x800000u) - 0x800000u); }
+static inline int32_t sbu_fast_read_i24le(sbu_t *src) { return sbu_sext24(sbu_fast_read_u24le(src)); }
+static inline int32_t sbu_fast_read_i24be(sbu_t *src) { return sbu_sext24(sbu_fast_read_u24be(src)); }
+
+static inline float sbu_fast_read_f32le(sbu_t *src) { return sbu_bits_f32(sbu_fast_read_u32le(src)); }
+static inline float sbu_fast_read_f32be(sbu_t *src) { return sbu_bits_f32(sbu_fast_read_u32be(src)); }
+static inline double sbu_fast_read_f64le(sbu_t *src) { return sbu_bits_f64(sbu_fast_read_u64le(src)); }
+static inline double sbu_fast_read_f64be(sbu_t *src) { return sbu_bits_f64(sbu_fast_read_u64be(src)); }
+
+// Varint: LEB128, младшие 7 бит первыми, старший бит - «есть продолжение».
+// Знаковые значения - zigzag (0, -1, 1, -2 -> 0, 1, 2, 3), чтобы малые
+// по модулю отрицательные тоже занимали один-два байта
+#define SBU_VARINT_MAX 10
+
+static inline uint64_t sbu_zigzag64(int64_t v) { return ((uint64_t)v << 1) ^ (0 - ((uint64_t)v >> 63)); }
+static inline int64_t sbu_unzigzag64(uint64_t v) { return (int64_t)((v >> 1) ^ (0 - (v & 1))); }
+
+static inline int sbu_uvarint_size(uint64_t v)
+{
+    int n = 1;
+    while (v >= 0x80) { v >>= 7; n++; }
+    return n;
+}
+
+static inline void sbu_fast_write_uvarint(sbu_t *dst, uint64_t val)
+{
+    uint8_t *p = dst->ptr;
+    while (val >= 0x80)
+    {
+        *p++ = (uint8_t)val | 0x80;
+        val >>= 7;
+    }
+    *p++ = (uint8_t)val;
+    dst->ptr = p;
+}
+
+static inline void sbu_fast_write_svarint(sbu_t *dst, int64_t val) { sbu_fast_write_uvarint(dst, sbu_zigzag64(val)); }
+
+static inline bool sbu_fast_write_uvarint_safe(sbu_t *dst, uint64_t val)
+{
+    if (!dst || sbu_fast_left(dst) < sbu_uvarint_size(val)) return false;
+    sbu_fast_write_uvarint(dst, val);
+    return true;
+}
+
+static inline bool sbu_fast_write_svarint_safe(sbu_t *dst, int64_t val) { return sbu_fast_write_uvarint_safe(dst, sbu_zigzag64(val)); }
+
+// Разбор не дальше limit байт; 0 - значение не закончилось или длиннее
+// 64 бит. Однобайтовые значения - без цикла
+static inline int sbu_varint_decode(const uint8_t *p, size_t limit, uint64_t *val)
+{
+    uint64_t v;
+    int i;
+    if (limit > SBU_VARINT_MAX) limit = SBU_VARINT_MAX;
+    if (limit && p[0] < 0x80)
+    {
+        *val = p[0];
+        return 1;
+    }
+    v = 0;
+    for (i = 0; i < (int)limit; i++)
+    {
+        v |= (uint64_t)(p[i] & 0x7F) << (7 * i);
+        if (p[i] < 0x80)
+        {
+            if (i == SBU_VARINT_MAX - 1 && p[i] > 1) return 0;
+            *val = v;
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+// Без проверки границ, как остальные sbu_read_*; испорченное значение - 0
+static inline uint64_t sbu_fast_read_uvarint(sbu_t *src)
+{
+    uint64_t v = 0;
+    int n = sbu_varint_decode(src->ptr, SBU_VARINT_MAX, &v);
+    src->ptr += n ? n : SBU_VARINT_MAX;
+    return n ? v : 0;
+}
+
+static inline int64_t sbu_fast_read_svarint(sbu_t *src) { return sbu_unzigzag64(sbu_fast_read_uvarint(src)); }
+
+static inline bool sbu_fast_read_uvarint_safe(uint64_t *val, sbu_t *src)
+{
+    uint64_t v;
+    int n;
+    if (!src) return false;
+    n = sbu_varint_decode(src->ptr, (size_t)sbu_fast_left(src), &v);
+    if (!n) return false;
+    src->ptr += n;
+    if (val) *val = v;
+    return true;
+}
+
+static inline bool sbu_fast_read_svarint_safe(int64_t *val, sbu_t *src)
+{
+    uint64_t v;
+    if (!sbu_fast_read_uvarint_safe(&v, src)) return false;
+    if (val) *val = sbu_unzigzag64(v);
+    return true;
+}
+
+// _safe: одна проверка длины, затем быстрый доступ
+#define SBU_FAST_READ_SAFE(name, type, size)                      \
+    static inline bool sbu_fast_read_##name##_safe(type *val, sbu_t *src) \
+    {                                                             \
+        if (!src || sbu_fast_left(src) < (size)) return false;    \
+        {                                                         \
+            type v = sbu_fast_read_##name(src);                   \
+            if (val) *val = v;                                    \
+        }                                                         \
+        return true;                                              \
+    }
+
+SBU_FAST_READ_SAFE(u8, uint8_t, 1)
+SBU_FAST_READ_SAFE(i8, int8_t, 1)
+SBU_FAST_READ_SAFE(u16le, uint16_t, 2)
+SBU_FAST_READ_SAFE(i16le, int16_t, 2)
+SBU_FAST_READ_SAFE(u16be, uint16_t, 2)
+SBU_FAST_READ_SAFE(i16be, int16_t, 2)
+SBU_FAST_READ_SAFE(u32le, uint32_t, 4)
+SBU_FAST_READ_SAFE(i32le, int32_t, 4)
+SBU_FAST_READ_SAFE(u32be, uint32_t, 4)
+SBU_FAST_READ_SAFE(i32be, int32_t, 4)
+SBU_FAST_READ_SAFE(u24le, uint32_t, 3)
+SBU_FAST_READ_SAFE(i24le, int32_t, 3)
+SBU_FAST_READ_SAFE(u24be, uint32_t, 3)
+SBU_FAST_READ_SAFE(i24be, int32_t, 3)
+SBU_FAST_READ_SAFE(u64le, uint64_t, 8)
+SBU_FAST_READ_SAFE(i64le, int64_t, 8)
+SBU_FAST_READ_SAFE(u64be, uint64_t, 8)
+SBU_FAST_READ_SAFE(i64be, int64_t, 8)
+SBU_FAST_READ_SAFE(f32le, float, 4)
+SBU_FAST_READ_SAFE(f32be, float, 4)
+SBU_FAST_READ_SAFE(f64le, double, 8)
+SBU_FAST_READ_SAFE(f64be, double, 8)
+
+static inline bool sbu_fast_write_data_safe(sbu_t *dst, const void *data, int len)
+{
+    if (!dst || !data || len <= 0) return false;
+    if (sbu_fast_left(dst) < len) return false;
+    memcpy(dst->ptr, data, (size_t)len);
+    dst->ptr += len;
+    return true;
+}
+
+static inline bool sbu_fast_read_data_safe(sbu_t *src, void *data, int len)
+{
+    if (!src || len <= 0) return false;
+    if (sbu_fast_left(src) < len) return false;
+    sbu_fast_read_data(src, data, len);
+    return true;
+}
+
+// Курсор с «липкой» ошибкой: проверка границ без ветвлений у вызывающего.
+// Чтение за концом возвращает 0, запись за концом отбрасывается, и в обоих
+// случаях выставляется overflow; результат проверяется один раз в конце:
+//
+//   sbu_cur_t c;
+//   sbu_cur_init(&c, buf, buf + len);
+//   hdr.id  = sbu_cur_read_u16le(&c);
+//   hdr.len = sbu_cur_read_u32le(&c);
+//   if (!sbu_cur_ok(&c)) return false;
+//
+// Пакетный вариант: sbu_cur_ensure(&c, n) один раз доказывает, что n байт
+// есть, дальше - непроверяемые sbu_read_*/sbu_write_* по &c.buf.
+
+typedef struct sbu_cur_s {
+    sbu_t buf;
+    bool overflow;
+} sbu_cur_t;
+
+static inline sbu_cur_t *sbu_cur_init(sbu_cur_t *c, uint8_t *ptr, uint8_t *end)
+{
+    c->buf.ptr = ptr;
+    c->buf.end = (ptr && end && end >= ptr) ? end : ptr;
+    c->overflow = false;
+    return c;
+}
+
+static inline bool sbu_cur_ok(const sbu_cur_t *c) { return !c->overflow; }
+static inline size_t sbu_cur_left(const sbu_cur_t *c) { return (size_t)(c->buf.end - c->buf.ptr); }
+
+static inline bool sbu_cur_ensure(sbu_cur_t *c, size_t n)
+{
+    c->overflow |= sbu_cur_left(c) < n;
+    return !c->overflow;
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SBU_LIKELY(x) __builtin_expect(!!(x), 1)
+#else
+#define SBU_LIKELY(x) (x)
+#endif
+
+// Указатель на n байт в буфере или, при нехватке, на нулевой блок.
+// Ветка почти всегда угадывается, а ptr двигается без зависимости от
+// сравнения (cmov здесь сериализовал бы все поля записи)
+static inline const uint8_t *sbu_cur_take(sbu_cur_t *c, size_t n)
+{
+    static const uint8_t zero[8] = {0};
+    const uint8_t *p = c->buf.ptr;
+    if (SBU_LIKELY(sbu_cur_left(c) >= n))
+    {
+        c->buf.ptr += n;
+        return p;
+    }
+    c->overflow = true;
+    return zero;
+}
+
+// То же для записи: при нехватке запись уходит в sink вызывающего
+static inline uint8_t *sbu_cur_space(sbu_cur_t *c, size_t n, uint8_t *sink)
+{
+    uint8_t *p = c->buf.ptr;
+    if (SBU_LIKELY(sbu_cur_left(c) >= n))
+    {
+        c->buf.ptr += n;
+        return p;
+    }
+    c->overflow = true;
+    return sink;
+}
+
+static inline void sbu_cur_skip(sbu_cur_t *c, size_t n)
+{
+    if (SBU_LIKELY(sbu_cur_left(c) >= n))
+        c->buf.ptr += n;
+    else
+        c->overflow = true;
+}
+
+static inline void sbu_cur_read_data(sbu_cur_t *c, void *data, size_t len)
+{
+    if (sbu_cur_left(c) >= len)
+    {
+        if (data) memcpy(data, c->buf.ptr, len);
+        c->buf.ptr += len;
+        return;
+    }
+    if (data) memset(data, 0, len);
+    c->overflow = true;
+}
+
+static inline void sbu_cur_write_data(sbu_cur_t *c, const void *data, size_t len)
+{
+    if (sbu_cur_left(c) >= len)
+    {
+        memcpy(c->buf.ptr, data, len);
+        c->buf.ptr += len;
+        return;
+    }
+    c->overflow = true;
+}
+
+static inline uint8_t sbu_cur_read_u8(sbu_cur_t *c) { return *sbu_cur_take(c, 1); }
+static inline int8_t sbu_cur_read_i8(sbu_cur_t *c) { return (int8_t)*sbu_cur_take(c, 1); }
+static inline uint16_t sbu_cur_read_u16le(sbu_cur_t *c) { return SBU_TO_LE16(sbu_load16(sbu_cur_take(c, 2))); }
+static inline uint16_t sbu_cur_read_u16be(sbu_cur_t *c) { return SBU_TO_BE16(sbu_load16(sbu_cur_take(c, 2))); }
+static inline uint32_t sbu_cur_read_u32le(sbu_cur_t *c) { return SBU_TO_LE32(sbu_load32(sbu_cur_take(c, 4))); }
+static inline uint32_t sbu_cur_read_u32be(sbu_cur_t *c) { return SBU_TO_BE32(sbu_load32(sbu_cur_take(c, 4))); }
+static inline int16_t sbu_cur_read_i16le(sbu_cur_t *c) { return (int16_t)sbu_cur_read_u16le(c); }
+static inline int16_t sbu_cur_read_i16be(sbu_cur_t *c) { return (int16_t)sbu_cur_read_u16be(c); }
+static inline int32_t sbu_cur_read_i32le(sbu_cur_t *c) { return (int32_t)sbu_cur_read_u32le(c); }
+static inline int32_t sbu_cur_read_i32be(sbu_cur_t *c) { return (int32_t)sbu_cur_read_u32be(c); }
+
+static inline uint32_t sbu_cur_read_u24le(sbu_cur_t *c)
+{
+    const uint8_t *p = sbu_cur_take(c, 3);
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+}
+
+static inline uint32_t sbu_cur_read_u24be(sbu_cur_t *c)
+{
+    const uint8_t *p = sbu_cur_take(c, 3);
+    return ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | (uint32_t)p[2];
+}
+
+static inline int32_t sbu_cur_read_i24le(sbu_cur_t *c) { return sbu_sext24(sbu_cur_read_u24le(c)); }
+static inline int32_t sbu_cur_read_i24be(sbu_cur_t *c) { return sbu_sext24(sbu_cur_read_u24be(c)); }
+
+static inline void sbu_cur_write_u8(sbu_cur_t *c, uint8_t val) { uint8_t sink[1]; *sbu_cur_space(c, 1, sink) = val; }
+static inline void sbu_cur_write_i8(sbu_cur_t *c, int8_t val) { uint8_t sink[1]; *sbu_cur_space(c, 1, sink) = (uint8_t)val; }
+static inline void sbu_cur_write_u16le(sbu_cur_t *c, uint16_t val) { uint8_t sink[2]; sbu_store16(sbu_cur_space(c, 2, sink), SBU_TO_LE16(val)); }
+static inline void sbu_cur_write_u16be(sbu_cur_t *c, uint16_t val) { uint8_t sink[2]; sbu_store16(sbu_cur_space(c, 2, sink), SBU_TO_BE16(val)); }
+static inline void sbu_cur_write_u32le(sbu_cur_t *c, uint32_t val) { uint8_t sink[4]; sbu_store32(sbu_cur_space(c, 4, sink), SBU_TO_LE32(val)); }
+static inline void sbu_cur_write_u32be(sbu_cur_t *c, uint32_t val) { uint8_t sink[4]; sbu_store32(sbu_cur_space(c, 4, sink), SBU_TO_BE32(val)); }
+static inline void sbu_cur_write_u64le(sbu_cur_t *c, uint64_t val) { uint8_t sink[8]; sbu_store64(sbu_cur_space(c, 8, sink), SBU_TO_LE64(val)); }
+static inline void sbu_cur_write_u64be(sbu_cur_t *c, uint64_t val) { uint8_t sink[8]; sbu_store64(sbu_cur_space(c, 8, sink), SBU_TO_BE64(val)); }
+static inline void sbu_cur_write_f32le(sbu_cur_t *c, float val) { sbu_cur_write_u32le(c, sbu_f32_bits(val)); }
+static inline void sbu_cur_write_f32be(sbu_cur_t *c, float val) { sbu_cur_write_u32be(c, sbu_f32_bits(val)); }
+static inline void sbu_cur_write_f64le(sbu_cur_t *c, double val) { sbu_cur_write_u64le(c, sbu_f64_bits(val)); }
+static inline void sbu_cur_write_f64be(sbu_cur_t *c, double val) { sbu_cur_write_u64be(c, sbu_f64_bits(val)); }
+
+static inline void sbu_cur_write_u24le(sbu_cur_t *c, uint32_t val)
+{
+    uint8_t sink[3];
+    uint8_t *p = sbu_cur_space(c, 3, sink);
+    p[0] = (uint8_t)val;
+    p[1] = (uint8_t)(val >> 8);
+    p[2] = (uint8_t)(val >> 16);
+}
+
+static inline void sbu_cur_write_u24be(sbu_cur_t *c, uint32_t val)
+{
+    uint8_t sink[3];
+    uint8_t *p = sbu_cur_space(c, 3, sink);
+    p[0] = (uint8_t)(val >> 16);
+    p[1] = (uint8_t)(val >> 8);
+    p[2] = (uint8_t)val;
+}
+
+static inline uint64_t sbu_cur_read_u64le(sbu_cur_t *c) { return SBU_TO_LE64(sbu_load64(sbu_cur_take(c, 8))); }
+static inline uint64_t sbu_cur_read_u64be(sbu_cur_t *c) { return SBU_TO_BE64(sbu_load64(sbu_cur_take(c, 8))); }
+static inline int64_t sbu_cur_read_i64le(sbu_cur_t *c) { return (int64_t)sbu_cur_read_u64le(c); }
+static inline int64_t sbu_cur_read_i64be(sbu_cur_t *c) { return (int64_t)sbu_cur_read_u64be(c); }
+static inline float sbu_cur_read_f32le(sbu_cur_t *c) { return sbu_bits_f32(sbu_cur_read_u32le(c)); }
+static inline float sbu_cur_read_f32be(sbu_cur_t *c) { return sbu_bits_f32(sbu_cur_read_u32be(c)); }
+static inline double sbu_cur_read_f64le(sbu_cur_t *c) { return sbu_bits_f64(sbu_cur_read_u64le(c)); }
+static inline double sbu_cur_read_f64be(sbu_cur_t *c) { return sbu_bits_f64(sbu_cur_read_u64be(c)); }
+
+static inline void sbu_cur_write_uvarint(sbu_cur_t *c, uint64_t val)
+{
+    if (!sbu_fast_write_uvarint_safe(&c->buf, val)) c->overflow = true;
+}
+
+static inline uint64_t sbu_cur_read_uvarint(sbu_cur_t *c)
+{
+    uint64_t v = 0;
+    if (!sbu_fast_read_uvarint_safe(&v, &c->buf)) c->overflow = true;
+    return v;
+}
+
+static inline void sbu_cur_write_svarint(sbu_cur_t *c, int64_t val) { sbu_cur_write_uvarint(c, sbu_zigzag64(val)); }
+static inline int64_t sbu_cur_read_svarint(sbu_cur_t *c) { return sbu_unzigzag64(sbu_cur_read_uvarint(c)); }
+
+// Растущий построитель кадра неизвестной длины. Память берется из
+// арены (bump-аллокатор над памятью вызывающего или slab потока) или,
+// без арены, из кучи. Кадр, лежащий на вершине арены, растет на месте
+// без копирования; емкость удваивается, поэтому запись - одно сравнение
+// в среднем. Ошибка выделения «липкая», как у sbu_cur_t:
+//
+//   sbu_dyn_t d;
+//   sbu_dyn_init(&d, sbu_arena_thread(), 256);
+//   sbu_dyn_write_u16le(&d, id);
+//   sbu_dyn_write_data(&d, payload, n);
+//   sbu_t frame = sbu_dyn_finish(&d);   // frame.ptr..frame.end, без копии
+//   send(frame);
+//   sbu_arena_reset(sbu_arena_thread()); // кадры больше не нужны
+//
+// Пакетно: sbu_dyn_reserve(&d, n), затем sbu_write_* по &d.buf.
+//
+// Арена сама не освобождается: готовые кадры занимают ее до
+// sbu_arena_reset. Без сброса (например, раз за итерацию цикла событий)
+// она заполняется, и sbu_dyn_init/grow начинают отказывать навсегда.
+// Кадр больше арены (для slab потока - SBU_THREAD_SLAB) в нее не влезет
+// вовсе: такие строят с arena = NULL, в куче.
+
+typedef struct sbu_arena_s {
+    uint8_t *base;
+    size_t size;
+    size_t used;
+} sbu_arena_t;
+
+typedef struct sbu_dyn_s {
+    sbu_t buf;          // ptr - позиция записи, end - конец емкости
+    uint8_t *base;      // начало кадра
+    sbu_arena_t *arena; // NULL - malloc/realloc
+    bool failed;
+} sbu_dyn_t;
+
+#ifndef SBU_THREAD_SLAB
+#define SBU_THREAD_SLAB (64 * 1024)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void sbu_arena_init(sbu_arena_t *arena, void *mem, size_t size);
+// Освободить все кадры арены разом
+void sbu_arena_reset(sbu_arena_t *arena);
+// Slab текущего потока (SBU_THREAD_SLAB байт, выделяется при первом вызове);
+// NULL, если памяти нет. Общий для всего кода потока: сбрасывает его
+// владелец цикла, когда все кадры итерации отправлены
+sbu_arena_t *sbu_arena_thread(void);
+
+bool sbu_dyn_init(sbu_dyn_t *dyn, sbu_arena_t *arena, size_t hint);
+// Медленный путь sbu_dyn_reserve: удвоить емкость, не меньше чем на n
+bool sbu_dyn_grow(sbu_dyn_t *dyn, size_t n);
+// Готовый кадр: ptr - начало, end - конец записанного. Лишняя емкость
+// возвращается арене; без арены кадр освобождают free(frame.ptr).
+// После ошибки - пустой кадр, память уже освобождена
+sbu_t sbu_dyn_finish(sbu_dyn_t *dyn);
+// Бросить кадр: вернуть память арене (если кадр на вершине) или куче
+void sbu_dyn_discard(sbu_dyn_t *dyn);
+
+#ifdef __cplusplus
+}
+#endif
+
+static inline bool sbu_dyn_ok(const sbu_dyn_t *dyn) { return !dyn->failed; }
+static inline size_t sbu_dyn_size(const sbu_dyn_t *dyn) { return (size_t)(dyn->buf.ptr - dyn->base); }
+
+static inline bool sbu_dyn_reserve(sbu_dyn_t *dyn, size_t n)
+{
+    if (SBU_LIKELY((size_t)(dyn->buf.end - dyn->buf.ptr) >= n)) return true;
+    return sbu_dyn_grow(dyn, n);
+}
+
+#define SBU_DYN_WRITE(name, type, size)                                  \
+    static inline void sbu_dyn_write_##name(sbu_dyn_t *dyn, type val)    \
+    {                                                                    \
+        if (sbu_dyn_reserve(dyn, size)) sbu_fast_write_##name(&dyn->buf, val); \
+    }
+
+SBU_DYN_WRITE(u8, uint8_t, 1)
+SBU_DYN_WRITE(i8, int8_t, 1)
+SBU_DYN_WRITE(u16le, uint16_t, 2)
+SBU_DYN_WRITE(u16be, uint16_t, 2)
+SBU_DYN_WRITE(u24le, uint32_t, 3)
+SBU_DYN_WRITE(u24be, uint32_t, 3)
+SBU_DYN_WRITE(u32le, uint32_t, 4)
+SBU_DYN_WRITE(u32be, uint32_t, 4)
+SBU_DYN_WRITE(u64le, uint64_t, 8)
+SBU_DYN_WRITE(u64be, uint64_t, 8)
+SBU_DYN_WRITE(f32le, float, 4)
+SBU_DYN_WRITE(f32be, float, 4)
+SBU_DYN_WRITE(f64le, double, 8)
+SBU_DYN_WRITE(f64be, double, 8)
+SBU_DYN_WRITE(uvarint, uint64_t, SBU_VARINT_MAX)
+SBU_DYN_WRITE(svarint, int64_t, SBU_VARINT_MAX)
+
+static inline void sbu_dyn_write_data(sbu_dyn_t *dyn, const void *data, size_t len)
+{
+    if (len && sbu_dyn_reserve(dyn, len))
+    {
+        memcpy(dyn->buf.ptr, data, len);
+        dyn->buf.ptr += len;
+    }
+}
+
+static inline void sbu_dyn_write_string(sbu_dyn_t *dyn, const char *string)
+{
+    sbu_dyn_write_data(dyn, string, strlen(string));
+}
+
+// Побитовый курсор для упакованных протоколов (SBUS, CRSF): поля по
+// 1..32 бита через 64-битный аккумулятор. lsb - первое поле в младших
+// битах первого байта (SBUS, CRSF), msb - в старших. Порядок на одном
+// курсоре не смешивать. Ошибки «липкие», как у sbu_cur_t: чтение за
+// концом дает нули, запись за концом отбрасывается.
+//
+//   sbu_bits_t b;
+//   sbu_bits_init(&b, buf, buf + len);
+//   flags = sbu_bits_read_lsb(&b, 4);
+//   value = sbu_bits_read_lsb(&b, 11);
+//
+// Писатель после последнего поля вызывает sbu_bits_flush_*: неполный
+// байт дополняется нулями.
+
+typedef struct sbu_bits_s {
+    uint8_t *ptr;
+    uint8_t *end;
+    uint64_t acc;
+    int count;      // бит в acc
+    bool overflow;
+} sbu_bits_t;
+
+static inline sbu_bits_t *sbu_bits_init(sbu_bits_t *b, uint8_t *ptr, uint8_t *end)
+{
+    b->ptr = ptr;
+    b->end = (ptr && end && end >= ptr) ? end : ptr;
+    b->acc = 0;
+    b->count = 0;
+    b->overflow = false;
+    return b;
+}
+
+static inline bool sbu_bits_ok(const sbu_bits_t *b) { return !b->overflow; }
+
+// Дозагрузка до 56+ бит. Из 8 байт берутся целые байты, остаток
+// аккумулятора уже содержит те же биты, поэтому OR безопасен
+static inline void sbu_bits_refill_lsb(sbu_bits_t *b)
+{
+    if (SBU_LIKELY(b->end - b->ptr >= 8))
+    {
+        int bytes = (63 - b->count) >> 3;
+        b->acc |= SBU_TO_LE64(sbu_load64(b->ptr)) << b->count;
+        b->ptr += bytes;
+        b->count += bytes << 3;
+        return;
+    }
+    while (b->count <= 56 && b->ptr < b->end)
+    {
+        b->acc |= (uint64_t)*b->ptr++ << b->count;
+        b->count += 8;
+    }
+}
+
+static inline void sbu_bits_refill_msb(sbu_bits_t *b)
+{
+    if (SBU_LIKELY(b->end - b->ptr >= 8))
+    {
+        int bytes = (63 - b->count) >> 3;
+        b->acc |= SBU_TO_BE64(sbu_load64(b->ptr)) >> b->count;
+        b->ptr += bytes;
+        b->count += bytes << 3;
+        return;
+    }
+    while (b->count <= 56 && b->ptr < b->end)
+    {
+        b->acc |= (uint64_t)*b->ptr++ << (56 - b->count);
+        b->count += 8;
+    }
+}
+
+static inline uint32_t sbu_bits_read_lsb(sbu_bits_t *b, int n)
+{
+    uint32_t v;
+    if (b->count < n)
+    {
+        sbu_bits_refill_lsb(b);
+        if (b->count < n)
+        {
+            b->overflow = true;
+            b->acc = 0;
+            b->count = 0;
+            return 0;
+        }
+    }
+    v = (uint32_t)(b->acc & ((1ULL << n) - 1));
+    b->acc >>= n;
+    b->count -= n;
+    return v;
+}
+
+static inline uint32_t sbu_bits_read_msb(sbu_bits_t *b, int n)
+{
+    uint32_t v;
+    if (b->count < n)
+    {
+        sbu_bits_refill_msb(b);
+        if (b->count < n)
+        {
+            b->overflow = true;
+            b->acc = 0;
+            b->count = 0;
+            return 0;
+        }
+    }
+    v = (uint32_t)(b->acc >> (64 - n));
+    b->acc <<= n;
+    b->count -= n;
+    return v;
+}
+
+static inline int32_t sbu_bits_read_signed_lsb(sbu_bits_t *b, int n)
+{
+    uint32_t sign = 1u << (n - 1);
+    return (int32_t)((sbu_bits_read_lsb(b, n) ^ sign) - sign);
+}
+
+// Читателю: отбросить биты до границы байта. Целые непрочитанные байты
+// возвращаются в буфер, поэтому годится для обоих порядков
+static inline void sbu_bits_align(sbu_bits_t *b)
+{
+    b->ptr -= b->count >> 3;
+    b->acc = 0;
+    b->count = 0;
+}
+
+static inline void sbu_bits_put(sbu_bits_t *b, uint8_t byte)
+{
+    if (b->ptr < b->end)
+        *b->ptr++ = byte;
+    else
+        b->overflow = true;
+}
+
+static inline void sbu_bits_write_lsb(sbu_bits_t *b, uint32_t v, int n)
+{
+    b->acc |= (uint64_t)(v & (uint32_t)((1ULL << n) - 1)) << b->count;
+    b->count += n;
+    if (b->count >= 32)
+    {
+        if (SBU_LIKELY(b->end - b->ptr >= 4))
+        {
+            sbu_store32(b->ptr, SBU_TO_LE32((uint32_t)b->acc));
+            b->ptr += 4;
+        }
+        else
+        {
+            int i;
+            for (i = 0; i < 4; i++) sbu_bits_put(b, (uint8_t)(b->acc >> (8 * i)));
+        }
+        b->acc >>= 32;
+        b->count -= 32;
+    }
+}
+
+static inline void sbu_bits_write_msb(sbu_bits_t *b, uint32_t v, int n)
+{
+    b->acc |= (uint64_t)(v & (uint32_t)((1ULL << n) - 1)) << (64 - b->count - n);
+    b->count += n;
+    if (b->count >= 32)
+    {
+        if (SBU_LIKELY(b->end - b->ptr >= 4))
+        {
+            sbu_store32(b->ptr, SBU_TO_BE32((uint32_t)(b->acc >> 32)));
+            b->ptr += 4;
+        }
+        else
+        {
+            int i;
+            for (i = 0; i < 4; i++) sbu_bits_put(b, (uint8_t)(b->acc >> (56 - 8 * i)));
+        }
+        b->acc <<= 32;
+        b->count -= 32;
+    }
+}
+
+static inline void sbu_bits_flush_lsb(sbu_bits_t *b)
+{
+    while (b->count > 0)
+    {
+        sbu_bits_put(b, (uint8_t)b->acc);
+        b->acc >>= 8;
+        b->count -= 8;
+    }
+    b->acc = 0;
+    b->count = 0;
+}
+
+static inline void sbu_bits_flush_msb(sbu_bits_t *b)
+{
+    while (b->count > 0)
+    {
+        sbu_bits_put(b, (uint8_t)(b->acc >> 56));
+        b->acc <<= 8;
+        b->count -= 8;
+    }
+    b->acc = 0;
+    b->count = 0;
+}
+
+#define SBU_CH11_BYTES 22
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 16 каналов по 11 бит, lsb (раскладка SBUS и CRSF RC_CHANNELS_PACKED):
+// 22 байта без циклов, две 64-битные загрузки на 8 каналов
+void sbu_pack_ch11x16(uint8_t *dst, const uint16_t *ch);
+void sbu_unpack_ch11x16(uint16_t *ch, const uint8_t *src);
+
+#ifdef __cplusplus
+}
+#endif
+
+// Base64 (RFC 4648, обычный и URL-safe алфавит) и hex. Пишут в курсор
+// без выделения памяти; при нехватке места или неверном вводе возвращают
+// false и не двигают dst->ptr. Векторные ядра: AVX2/SSSE3 (base64),
+// SSE2 (hex), NEON (кодирование), иначе скалярный код
+
+#define SBU_BASE64_URL   0x01 // '-' и '_' вместо '+' и '/'
+#define SBU_BASE64_NOPAD 0x02 // без '=' в конце (при разборе '=' допустимы всегда)
+#define SBU_HEX_UPPER    0x01
+
+static inline size_t sbu_base64_encoded_size(size_t len, int flags)
+{
+    if (flags & SBU_BASE64_NOPAD) return len / 3 * 4 + (len % 3 ? len % 3 + 1 : 0);
+    return (len + 2) / 3 * 4;
+}
+
+// Верхняя оценка для разбора text длины len
+static inline size_t sbu_base64_decoded_max(size_t len) { return (len + 3) / 4 * 3; }
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+bool sbu_base64_encode(sbu_t *dst, const void *data, size_t len, int flags);
+bool sbu_base64_decode(sbu_t *dst, const char *text, size_t len, int flags);
+// Две цифры на байт; при разборе регистр любой, длина четная
+bool sbu_hex_encode(sbu_t *dst, const void *data, size_t len, int flags);
+bool sbu_hex_decode(sbu_t *dst, const char *text, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+// Публичные имена: static inline обертки над sbu_fast_*, с SBU_NO_INLINE -
+// объявления внешних символов из sbu.c (адрес функции, вызовы из других
+// языков). Функции, а не макросы: одноименные идентификаторы C++ (методы,
+// поля) не переписываются препроцессором
+#ifdef SBU_NO_INLINE
+#define SBU_API(ret, name, params, args) ret sbu_##name params;
+#define SBU_API_VOID(name, params, args) void sbu_##name params;
+#else
+#define SBU_API(ret, name, params, args) \
+    static inline ret sbu_##name params { return sbu_fast_##name args; }
+#define SBU_API_VOID(name, params, args) \
+    static inline void sbu_##name params { sbu_fast_##name args; }
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// init
+SBU_API(sbu_t *, init, (sbu_t *sbu, uint8_t *ptr, uint8_t *end), (sbu, ptr, end))
+
+// utils
+SBU_API(int, left, (sbu_t *buf), (buf)) // осталось
+SBU_API_VOID(skip, (sbu_t *buf, int size), (buf, size)) // сдвинуть
+
+// sbu_write basic
+SBU_API_VOID(write_data, (sbu_t *dst, const void *data, int len), (dst, data, len))
+SBU_API(bool, write_data_safe, (sbu_t *dst, const void *data, int len), (dst, data, len))
+SBU_API_VOID(write_u8, (sbu_t *dst, uint8_t val), (dst, val))
+SBU_API_VOID(write_i8, (sbu_t *dst, int8_t val), (dst, val))
+
+// sbu_write advanced
+SBU_API_VOID(write_u16le, (sbu_t *dst, uint16_t val), (dst, val))
+SBU_API_VOID(write_u16be, (sbu_t *dst, uint16_t val), (dst, val))
+SBU_API_VOID(write_u24le, (sbu_t *dst, uint32_t val), (dst, val))
+SBU_API_VOID(write_u24be, (sbu_t *dst, uint32_t val), (dst, val))
+SBU_API_VOID(write_u32le, (sbu_t *dst, uint32_t val), (dst, val))
+SBU_API_VOID(write_u32be, (sbu_t *dst, uint32_t val), (dst, val))
+SBU_API_VOID(write_u64le, (sbu_t *dst, uint64_t val), (dst, val))
+SBU_API_VOID(write_u64be, (sbu_t *dst, uint64_t val), (dst, val))
+SBU_API_VOID(write_f32le, (sbu_t *dst, float val), (dst, val))
+SBU_API_VOID(write_f32be, (sbu_t *dst, float val), (dst, val))
+SBU_API_VOID(write_f64le, (sbu_t *dst, double val), (dst, val))
+SBU_API_VOID(write_f64be, (sbu_t *dst, double val), (dst, val))
+
+// sbu_write varint (LEB128, s - zigzag)
+SBU_API_VOID(write_uvarint, (sbu_t *dst, uint64_t val), (dst, val))
+SBU_API_VOID(write_svarint, (sbu_t *dst, int64_t val), (dst, val))
+SBU_API(bool, write_uvarint_safe, (sbu_t *dst, uint64_t val), (dst, val))
+SBU_API(bool, write_svarint_safe, (sbu_t *dst, int64_t val), (dst, val))
+
 // sbu_read basic
-void sbu_read_data (sbu_t *src, void *data, int len);
-uint8_t sbu_read_u8(sbu_t *src);
-int8_t  sbu_read_i8(sbu_t *src);
+SBU_API_VOID(read_data, (sbu_t *src, void *data, int len), (src, data, len))
+SBU_API(uint8_t, read_u8, (sbu_t *src), (src))
+SBU_API(int8_t, read_i8, (sbu_t *src), (src))
 
 // sbu_read advanced
-uint16_t sbu_read_u16le(sbu_t *src);
-uint16_t sbu_read_u16be(sbu_t *src);
-int16_t sbu_read_i16le(sbu_t *src);
-int16_t sbu_read_i16be(sbu_t *src);
-// uint24_t sbu_read_u24le(sbu_t *src); feature
-// uint24_t sbu_read_u24be(sbu_t *src); feature
-// int24_t sbu_read_i24le(sbu_t *src); feature
-// int24_t sbu_read_i24be(sbu_t *src); feature
-uint32_t sbu_read_u32le(sbu_t *src);
-uint32_t sbu_read_u32be(sbu_t *src);
-int32_t sbu_read_i32le(sbu_t *src);
-int32_t sbu_read_i32be(sbu_t *src);
+SBU_API(uint16_t, read_u16le, (sbu_t *src), (src))
+SBU_API(uint16_t, read_u16be, (sbu_t *src), (src))
+SBU_API(int16_t, read_i16le, (sbu_t *src), (src))
+SBU_API(int16_t, read_i16be, (sbu_t *src), (src))
+SBU_API(uint32_t, read_u24le, (sbu_t *src), (src))
+SBU_API(uint32_t, read_u24be, (sbu_t *src), (src))
+SBU_API(int32_t, read_i24le, (sbu_t *src), (src))
+SBU_API(int32_t, read_i24be, (sbu_t *src), (src))
+SBU_API(uint32_t, read_u32le, (sbu_t *src), (src))
+SBU_API(uint32_t, read_u32be, (sbu_t *src), (src))
+SBU_API(int32_t, read_i32le, (sbu_t *src), (src))
+SBU_API(int32_t, read_i32be, (sbu_t *src), (src))
+SBU_API(uint64_t, read_u64le, (sbu_t *src), (src))
+SBU_API(uint64_t, read_u64be, (sbu_t *src), (src))
+SBU_API(int64_t, read_i64le, (sbu_t *src), (src))
+SBU_API(int64_t, read_i64be, (sbu_t *src), (src))
+SBU_API(float, read_f32le, (sbu_t *src), (src))
+SBU_API(float, read_f32be, (sbu_t *src), (src))
+SBU_API(double, read_f64le, (sbu_t *src), (src))
+SBU_API(double, read_f64be, (sbu_t *src), (src))
+
+// sbu_read varint
+SBU_API(uint64_t, read_uvarint, (sbu_t *src), (src))
+SBU_API(int64_t, read_svarint, (sbu_t *src), (src))
 
 // sbu_read_*_save basic
-bool sbu_read_data_safe (sbu_t *src, void *data, int len);
-bool sbu_read_u8_safe   (uint8_t *val, sbu_t *src);
-bool sbu_read_i8_safe   (int8_t *val, sbu_t *src);
+SBU_API(bool, read_data_safe, (sbu_t *src, void *data, int len), (src, data, len))
+SBU_API(bool, read_u8_safe, (uint8_t *val, sbu_t *src), (val, src))
+SBU_API(bool, read_i8_safe, (int8_t *val, sbu_t *src), (val, src))
 
 // sbu_read_*_save advanced
-bool sbu_read_u16le_safe(uint16_t *val, sbu_t *src);
-bool sbu_read_i16le_safe(int16_t *val, sbu_t *src);
-bool sbu_read_u16be_safe(uint16_t *val, sbu_t *src);
-bool sbu_read_i16be_safe(int16_t *val, sbu_t *src);
-// bool sbu_read_u24le_safe(uint16_t *val, sbu_t *src); feature
-// bool sbu_read_i24le_safe(int32_t *val, sbu_t *src); feature
-// bool sbu_read_u24be_safe(int32_t *val, sbu_t *src); feature
-// bool sbu_read_i24be_safe(int32_t *val, sbu_t *src); feature
-bool sbu_read_u32le_safe(uint32_t *val, sbu_t *src);
-bool sbu_read_i32le_safe(int32_t *val, sbu_t *src);
-bool sbu_read_u32be_safe(uint32_t *val, sbu_t *src);
-bool sbu_read_i32be_safe(int32_t *val, sbu_t *src);
+SBU_API(bool, read_u16le_safe, (uint16_t *val, sbu_t *src), (val, src))
+SBU_API(bool, read_i16le_safe, (int16_t *val, sbu_t *src), (val, src))
+SBU_API(bool, read_u16be_safe, (uint16_t *val, sbu_t *src), (val, src))
+SBU_API(bool, read_i16be_safe, (int16_t *val, sbu_t *src), (val, src))
+SBU_API(bool, read_u24le_safe, (uint32_t *val, sbu_t *src), (val, src))
+SBU_API(bool, read_i24le_safe, (int32_t *val, sbu_t *src), (val, src))
+SBU_API(bool, read_u24be_safe, (uint32_t *val, sbu_t *src), (val, src))
+SBU_API(bool, read_i24be_safe, (int32_t *val, sbu_t *src), (val, src))
+SBU_API(bool, read_u32le_safe, (uint32_t *val, sbu_t *src), (val, src))
+SBU_API(bool, read_i32le_safe, (int32_t *val, sbu_t *src), (val, src))
+SBU_API(bool, read_u32be_safe, (uint32_t *val, sbu_t *src), (val, src))
+SBU_API(bool, read_i32be_safe, (int32_t *val, sbu_t *src), (val, src))
+SBU_API(bool, read_u64le_safe, (uint64_t *val, sbu_t *src), (val, src))
+SBU_API(bool, read_i64le_safe, (int64_t *val, sbu_t *src), (val, src))
+SBU_API(bool, read_u64be_safe, (uint64_t *val, sbu_t *src), (val, src))
+SBU_API(bool, read_i64be_safe, (int64_t *val, sbu_t *src), (val, src))
+SBU_API(bool, read_f32le_safe, (float *val, sbu_t *src), (val, src))
+SBU_API(bool, read_f32be_safe, (float *val, sbu_t *src), (val, src))
+SBU_API(bool, read_f64le_safe, (double *val, sbu_t *src), (val, src))
+SBU_API(bool, read_f64be_safe, (double *val, sbu_t *src), (val, src))
+SBU_API(bool, read_uvarint_safe, (uint64_t *val, sbu_t *src), (val, src))
+SBU_API(bool, read_svarint_safe, (int64_t *val, sbu_t *src), (val, src))
 
 #ifdef __cplusplus
 }
 #endif
+
+#undef SBU_API
+#undef SBU_API_VOID
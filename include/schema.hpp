@@ -0,0 +1,458 @@
+#pragma once
+
+// Схема сообщения на этапе компиляции: список полей с шириной на проводе,
+// порядком байт и масштабом. Из нее собираются encode/decode: размер
+// известен при компиляции, проверка границ одна на сообщение, смещения
+// полей - константы, код без циклов и ветвлений. Раскладка байт та же,
+// что у последовательности sbu_write_*.
+//
+//   struct Telemetry { uint16_t id; float temp; int32_t pos; };
+//
+//   using TelemetryWire = uSchema<Telemetry,
+//       uField<&Telemetry::id, uint16_t, uEndian::Big>,
+//       uField<&Telemetry::temp, int16_t, uEndian::Little, 1, 100>, // 0.01 градуса
+//       uPad<2>,
+//       uField<&Telemetry::pos, int32_t>>;
+//
+//   static_assert(TelemetryWire::size == 10, "");
+//   TelemetryWire::encode(&buf, msg);       // false - не хватило места
+//   TelemetryWire::decode(&buf, msg);       // false - не хватило данных
+
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
+#include <limits>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "sbu.h"
+
+enum class uEndian
+{
+    Little,
+    Big,
+};
+
+// 24-битные поля на проводе: значение в памяти - int32_t/uint32_t
+struct uU24
+{
+};
+struct uI24
+{
+};
+
+namespace usbu_detail
+{
+    // Наибольший double, не превышающий max() типа: у 64-битных max() как
+    // double округляется вверх до 2^63/2^64, и приведение обратно - UB
+    template <typename T>
+    constexpr double floorMax()
+    {
+        constexpr T max = std::numeric_limits<T>::max();
+        if constexpr (std::numeric_limits<T>::digits > std::numeric_limits<double>::digits)
+            return (double)(max - (max >> std::numeric_limits<double>::digits));
+        else
+            return (double)max;
+    }
+
+    // lo/hi - пределы поля как double (точные), min_value/max_value - в value_type
+    template <typename Wire>
+    struct WireTraits
+    {
+        static_assert(std::is_arithmetic<Wire>::value, "unsupported wire type");
+        using value_type = Wire;
+        static constexpr size_t size = sizeof(Wire);
+        static constexpr double lo = (double)std::numeric_limits<Wire>::lowest();
+        static constexpr double hi = floorMax<Wire>();
+        static constexpr Wire min_value = std::numeric_limits<Wire>::lowest();
+        static constexpr Wire max_value = std::numeric_limits<Wire>::max();
+    };
+    template <>
+    struct WireTraits<uU24>
+    {
+        using value_type = uint32_t;
+        static constexpr size_t size = 3;
+        static constexpr double lo = 0;
+        static constexpr double hi = 16777215.0;
+        static constexpr uint32_t min_value = 0;
+        static constexpr uint32_t max_value = 16777215;
+    };
+    template <>
+    struct WireTraits<uI24>
+    {
+        using value_type = int32_t;
+        static constexpr size_t size = 3;
+        static constexpr double lo = -8388608.0;
+        static constexpr double hi = 8388607.0;
+        static constexpr int32_t min_value = -8388608;
+        static constexpr int32_t max_value = 8388607;
+    };
+
+    template <auto A, auto B>
+    constexpr bool sameMember()
+    {
+        if constexpr (std::is_same<decltype(A), decltype(B)>::value)
+            return A == B;
+        else
+            return false;
+    }
+
+    template <typename T>
+    struct MemberOf;
+    template <typename C, typename T>
+    struct MemberOf<T C::*>
+    {
+        using type = T;
+        using owner = C;
+    };
+
+    template <typename Wire, uEndian Order>
+    inline void store(uint8_t *p, typename WireTraits<Wire>::value_type v)
+    {
+        constexpr bool le = Order == uEndian::Little;
+        if constexpr (WireTraits<Wire>::size == 3)
+        {
+            uint32_t u = (uint32_t)v;
+            p[le ? 0 : 2] = (uint8_t)u;
+            p[1] = (uint8_t)(u >> 8);
+            p[le ? 2 : 0] = (uint8_t)(u >> 16);
+        }
+        else if constexpr (sizeof(Wire) == 1)
+            p[0] = (uint8_t)v;
+        else if constexpr (std::is_same<Wire, float>::value)
+            sbu_store32(p, le ? SBU_TO_LE32(sbu_f32_bits(v)) : SBU_TO_BE32(sbu_f32_bits(v)));
+        else if constexpr (std::is_same<Wire, double>::value)
+            sbu_store64(p, le ? SBU_TO_LE64(sbu_f64_bits(v)) : SBU_TO_BE64(sbu_f64_bits(v)));
+        else if constexpr (sizeof(Wire) == 2)
+            sbu_store16(p, le ? SBU_TO_LE16((uint16_t)v) : SBU_TO_BE16((uint16_t)v));
+        else if constexpr (sizeof(Wire) == 4)
+            sbu_store32(p, le ? SBU_TO_LE32((uint32_t)v) : SBU_TO_BE32((uint32_t)v));
+        else
+            sbu_store64(p, le ? SBU_TO_LE64((uint64_t)v) : SBU_TO_BE64((uint64_t)v));
+    }
+
+    template <typename Wire, uEndian Order>
+    inline typename WireTraits<Wire>::value_type load(const uint8_t *p)
+    {
+        using V = typename WireTraits<Wire>::value_type;
+        constexpr bool le = Order == uEndian::Little;
+        if constexpr (WireTraits<Wire>::size == 3)
+        {
+            uint32_t u = (uint32_t)p[le ? 0 : 2] | ((uint32_t)p[1] << 8) | ((uint32_t)p[le ? 2 : 0] << 16);
+            if constexpr (std::is_same<Wire, uI24>::value)
+                return sbu_sext24(u);
+            else
+                return u;
+        }
+        else if constexpr (sizeof(Wire) == 1)
+            return (V)p[0];
+        else if constexpr (std::is_same<Wire, float>::value)
+            return sbu_bits_f32(le ? SBU_TO_LE32(sbu_load32(p)) : SBU_TO_BE32(sbu_load32(p)));
+        else if constexpr (std::is_same<Wire, double>::value)
+            return sbu_bits_f64(le ? SBU_TO_LE64(sbu_load64(p)) : SBU_TO_BE64(sbu_load64(p)));
+        else if constexpr (sizeof(Wire) == 2)
+            return (V)(le ? SBU_TO_LE16(sbu_load16(p)) : SBU_TO_BE16(sbu_load16(p)));
+        else if constexpr (sizeof(Wire) == 4)
+            return (V)(le ? SBU_TO_LE32(sbu_load32(p)) : SBU_TO_BE32(sbu_load32(p)));
+        else
+            return (V)(le ? SBU_TO_LE64(sbu_load64(p)) : SBU_TO_BE64(sbu_load64(p)));
+    }
+
+    // Дробное -> целое на проводе: с округлением и насыщением до пределов
+    // поля (для 24-битных - 24 бита), без UB при переполнении
+    template <typename Wire>
+    inline typename WireTraits<Wire>::value_type saturate(double x)
+    {
+        using V = typename WireTraits<Wire>::value_type;
+        if constexpr (std::is_floating_point<V>::value)
+            return (V)x;
+        else
+        {
+            x = x < 0 ? x - 0.5 : x + 0.5;
+            if (!(x > WireTraits<Wire>::lo))
+                return WireTraits<Wire>::min_value;
+            // hi представим точно: все, что больше, уже не влезает в поле
+            if (x > WireTraits<Wire>::hi)
+                return WireTraits<Wire>::max_value;
+            return (V)x;
+        }
+    }
+
+    // Целое -> целое на проводе с масштабом: v * Den / Num в intmax_t,
+    // переполнение произведения и выход за пределы поля насыщаются
+    template <typename Wire, intmax_t Num, intmax_t Den, typename T>
+    inline typename WireTraits<Wire>::value_type saturateScaled(T v)
+    {
+        using V = typename WireTraits<Wire>::value_type;
+        constexpr intmax_t limit = INTMAX_MAX / (Den < 0 ? -Den : Den);
+        constexpr bool flip = (Den < 0) != (Num < 0);
+        constexpr V low = WireTraits<Wire>::min_value;
+        constexpr V high = WireTraits<Wire>::max_value;
+
+        bool overflow;
+        if constexpr (std::is_unsigned<T>::value)
+            overflow = v > (uintmax_t)limit;
+        else
+            overflow = v > limit || v < -limit;
+        if (overflow)
+            return (v > 0) != flip ? high : low;
+
+        // |v * Den| <= INTMAX_MAX, поэтому и деление не переполняется
+        intmax_t x = (intmax_t)v * Den / Num;
+        if (x < 0)
+            return x < (intmax_t)low ? low : (V)x;
+        return (uintmax_t)x > (uintmax_t)high ? high : (V)x;
+    }
+} // namespace usbu_detail
+
+// Поле Member, на проводе - Wire с порядком Order. Масштаб: значение =
+// провод * Num / Den (например, 1/100 - сотые доли в целом поле)
+template <auto Member, typename Wire, uEndian Order = uEndian::Little, intmax_t Num = 1, intmax_t Den = 1>
+struct uField
+{
+    static_assert(Num != 0 && Den != 0, "zero scale");
+    using member_type = typename usbu_detail::MemberOf<decltype(Member)>::type;
+    using wire_value = typename usbu_detail::WireTraits<Wire>::value_type;
+    static constexpr size_t size = usbu_detail::WireTraits<Wire>::size;
+    static constexpr bool scaled = Num != 1 || Den != 1;
+
+    static constexpr auto member = Member;
+
+    static inline void write(uint8_t *p, const member_type &v)
+    {
+        wire_value w;
+        if constexpr (scaled && (std::is_floating_point<member_type>::value || std::is_floating_point<wire_value>::value))
+            w = usbu_detail::saturate<Wire>((double)v * (double)Den / (double)Num);
+        else if constexpr (scaled)
+            w = usbu_detail::saturateScaled<Wire, Num, Den>(v);
+        else if constexpr (std::is_floating_point<member_type>::value && !std::is_floating_point<wire_value>::value)
+            w = usbu_detail::saturate<Wire>((double)v);
+        else
+            w = (wire_value)v;
+        usbu_detail::store<Wire, Order>(p, w);
+    }
+
+    static inline member_type read(const uint8_t *p)
+    {
+        wire_value w = usbu_detail::load<Wire, Order>(p);
+        if constexpr (scaled && std::is_floating_point<member_type>::value)
+            return (member_type)((double)w * (double)Num / (double)Den);
+        else if constexpr (scaled)
+            return (member_type)((intmax_t)w * Num / Den);
+        else
+            return (member_type)w;
+    }
+
+    template <typename Msg>
+    static inline void encode(uint8_t *p, const Msg &msg) { write(p, msg.*Member); }
+    template <typename Msg>
+    static inline void decode(const uint8_t *p, Msg &msg) { msg.*Member = read(p); }
+};
+
+// N байт-заполнителей: при записи нули, при чтении пропускаются
+template <size_t N>
+struct uPad
+{
+    static constexpr size_t size = N;
+    static constexpr std::nullptr_t member = nullptr;
+
+    template <typename Msg>
+    static inline void encode(uint8_t *p, const Msg &) { memset(p, 0, N); }
+    template <typename Msg>
+    static inline void decode(const uint8_t *, Msg &) {}
+};
+
+// Массив байт как есть (uint8_t[N], char[N]) - sbu_write_data/sbu_read_data
+template <auto Member>
+struct uRaw
+{
+    using member_type = typename usbu_detail::MemberOf<decltype(Member)>::type;
+    static_assert(std::is_array<member_type>::value && sizeof(std::remove_extent_t<member_type>) == 1,
+                  "uRaw needs a byte array member");
+    static constexpr size_t size = sizeof(member_type);
+    static constexpr auto member = Member;
+
+    // В представлении (uView) - указатель прямо в буфер
+    static inline const uint8_t *read(const uint8_t *p) { return p; }
+    static inline void write(uint8_t *p, const member_type &v) { memcpy(p, v, size); }
+
+    template <typename Msg>
+    static inline void encode(uint8_t *p, const Msg &msg) { memcpy(p, msg.*Member, size); }
+    template <typename Msg>
+    static inline void decode(const uint8_t *p, Msg &msg) { memcpy(msg.*Member, p, size); }
+};
+
+template <typename Msg, typename... Fields>
+class uSchema
+{
+public:
+    using message_type = Msg;
+    static constexpr size_t size = (Fields::size + ... + 0);
+    static constexpr size_t count = sizeof...(Fields);
+
+    // Без проверок: в p должно быть не меньше size байт
+    static inline void encodeTo(uint8_t *p, const Msg &msg)
+    {
+        encodeAt(p, msg, std::index_sequence_for<Fields...>{});
+    }
+
+    static inline void decodeFrom(const uint8_t *p, Msg &msg)
+    {
+        decodeAt(p, msg, std::index_sequence_for<Fields...>{});
+    }
+
+    static inline bool encode(sbu_t *dst, const Msg &msg)
+    {
+        if (!dst || sbu_fast_left(dst) < (int)size)
+            return false;
+        encodeTo(dst->ptr, msg);
+        dst->ptr += size;
+        return true;
+    }
+
+    static inline bool decode(sbu_t *src, Msg &msg)
+    {
+        if (!src || sbu_fast_left(src) < (int)size)
+            return false;
+        decodeFrom(src->ptr, msg);
+        src->ptr += size;
+        return true;
+    }
+
+    // Курсор с «липкой» ошибкой: при нехватке места сообщение целиком
+    // не пишется (не читается) и выставляется overflow
+    static inline void encode(sbu_cur_t *c, const Msg &msg)
+    {
+        if (sbu_cur_ensure(c, size))
+        {
+            encodeTo(c->buf.ptr, msg);
+            c->buf.ptr += size;
+        }
+    }
+
+    static inline void decode(sbu_cur_t *c, Msg &msg)
+    {
+        if (sbu_cur_ensure(c, size))
+        {
+            decodeFrom(c->buf.ptr, msg);
+            c->buf.ptr += size;
+        }
+    }
+
+    template <size_t I>
+    using field = std::tuple_element_t<I, std::tuple<Fields...>>;
+
+    // Номер поля с членом M (uPad не находится)
+    template <auto M>
+    static constexpr size_t indexOf()
+    {
+        constexpr bool found[] = {usbu_detail::sameMember<Fields::member, M>()..., false};
+        size_t i = 0;
+        while (i < count && !found[i])
+            i++;
+        return i;
+    }
+
+    // Смещение поля I от начала сообщения
+    template <size_t I>
+    static constexpr size_t offset()
+    {
+        constexpr size_t sizes[] = {Fields::size..., 0};
+        size_t off = 0;
+        for (size_t i = 0; i < I; i++)
+            off += sizes[i];
+        return off;
+    }
+
+private:
+    template <size_t... I>
+    static inline void encodeAt(uint8_t *p, const Msg &msg, std::index_sequence<I...>)
+    {
+        (Fields::encode(p + std::integral_constant<size_t, offset<I>()>::value, msg), ...);
+    }
+
+    template <size_t... I>
+    static inline void decodeAt(const uint8_t *p, Msg &msg, std::index_sequence<I...>)
+    {
+        (Fields::decode(p + std::integral_constant<size_t, offset<I>()>::value, msg), ...);
+    }
+};
+
+// Представление сообщения поверх принятого буфера без копирования и
+// полного разбора: длина проверяется один раз в конструкторе, get<>
+// читает одно поле по смещению, известному при компиляции.
+//
+//   uView<TelemetryWire> v(packet, length);
+//   if (v && v.get<&Telemetry::id>() == 0x10)
+//       forward(v.data(), v.size());        // байты не тронуты
+//
+// Буфер должен жить дольше представления
+template <typename Schema>
+class uView
+{
+public:
+    using message_type = typename Schema::message_type;
+
+    uView() : m_ptr(nullptr), m_size(0) {}
+    uView(const uint8_t *data, size_t size)
+        : m_ptr(data && size >= Schema::size ? data : nullptr), m_size(m_ptr ? size : 0) {}
+    explicit uView(const sbu_t &window)
+        : uView(window.ptr, (size_t)sbu_fast_left(const_cast<sbu_t *>(&window))) {}
+
+    bool valid() const { return m_ptr != nullptr; }
+    explicit operator bool() const { return valid(); }
+
+    // Поле по члену структуры или по номеру в схеме; только для valid()
+    template <auto M>
+    auto get() const
+    {
+        constexpr size_t I = Schema::template indexOf<M>();
+        static_assert(I < Schema::count, "member is not in the schema");
+        return at<I>();
+    }
+
+    template <size_t I>
+    auto at() const
+    {
+        return Schema::template field<I>::read(m_ptr + Schema::template offset<I>());
+    }
+
+    // Полный разбор, если все-таки нужен
+    bool decode(message_type &msg) const
+    {
+        if (!valid())
+            return false;
+        Schema::decodeFrom(m_ptr, msg);
+        return true;
+    }
+
+    // Весь буфер (сообщение и то, что за ним) и данные после сообщения
+    const uint8_t *data() const { return m_ptr; }
+    size_t size() const { return m_size; }
+    const uint8_t *tail() const { return m_ptr ? m_ptr + Schema::size : nullptr; }
+    size_t tailSize() const { return m_ptr ? m_size - Schema::size : 0; }
+
+protected:
+    const uint8_t *m_ptr;
+    size_t m_size;
+};
+
+// То же с правкой полей на месте (счетчик пересылок, метка времени)
+template <typename Schema>
+class uMutableView : public uView<Schema>
+{
+public:
+    uMutableView() {}
+    uMutableView(uint8_t *data, size_t size) : uView<Schema>(data, size) {}
+    explicit uMutableView(const sbu_t &window) : uView<Schema>(window) {}
+
+    template <auto M, typename V>
+    void set(const V &value)
+    {
+        constexpr size_t I = Schema::template indexOf<M>();
+        static_assert(I < Schema::count, "member is not in the schema");
+        Schema::template field<I>::write(data() + Schema::template offset<I>(), value);
+    }
+
+    uint8_t *data() const { return const_cast<uint8_t *>(this->m_ptr); }
+};
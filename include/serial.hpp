@@ -89,6 +89,23 @@ struct termios2
 #include <IOKit/serial/ioss.h>
 #endif // __APPLE__
 
+// Задержка от обнаружения данных в poll() до их выдачи read()
+struct uSerialLatencyStats
+{
+    uint32_t samples;        // число измерений в окне
+    uint32_t p50_ns;
+    uint32_t p99_ns;
+    uint32_t spin_hits;      // данные пойманы активным ожиданием
+    uint32_t blocking_waits; // бюджет исчерпан, ушли в блокирующий ::poll
+};
+
+#define USERIAL_LATENCY_WINDOW 1024
+
+// Наибольшая посылка, которую dispatch() отдает onMessage целиком
+#ifndef USERIAL_PACKET_MAX
+#define USERIAL_PACKET_MAX 4096
+#endif
+
 class uSerial : public uStream
 {
 public:
@@ -102,21 +119,100 @@ public:
     bool attach(int fd) { return begin(fd); }
     bool attach(int fd, unsigned long baudrate) { return begin(fd, baudrate); }
 
+    // Пара связанных псевдотерминалов (master/slave), оба fd принадлежат
+    // объектам. Петля без железа для тестов и бенчмарков
+    static bool openPty(uSerial &master, uSerial &slave, unsigned long baudrate = 115200);
+
     void close() override;
     int available() const override;
     uint8_t read() override;
     size_t read(uint8_t *buffer, size_t length) override;
     size_t write(uint8_t byte) override;
     size_t write(const uint8_t *buffer, size_t length) override;
+    size_t writev(const struct iovec *iov, int iovcnt) override;
+    size_t readv(const struct iovec *iov, int iovcnt) override;
+    sbu_t acquireRead(size_t min = 1) override;
+    void releaseRead(size_t n) override;
     void flush() override;
     bool poll(int timeout_ms) override;
     bool isOpen() const override;
+    int pollFd() const override { return m_fd; }
+    // В пакетном режиме каждая посылка readPacket уходит в onMessage
+    size_t dispatch(int timeout_ms = 0) override;
+
+    // Смена скорости на открытом порту без переоткрытия fd.
+    // drain - дождаться отправки TX-буфера на старой скорости
+    bool setBaudrate(unsigned long baudrate, bool drain = true);
+    unsigned long baudrate() const { return m_baudrate; }
+
+    // Согласованная смена скорости с удаленной стороной: отправить request,
+    // дождаться ack на текущей скорости и только после этого переключиться.
+    // Если ack не пришел за timeout_ms (или не задан), скорость не меняется
+    bool negotiateBaudrate(unsigned long baudrate,
+                           const uint8_t *request, size_t request_len,
+                           const uint8_t *ack, size_t ack_len,
+                           uint32_t timeout_ms = 100);
+
+    // Без подтверждения: отправить request и сразу переключиться. Только
+    // для протоколов, где ответ на новой скорости проверяет сам вызывающий
+    bool requestBaudrate(unsigned long baudrate, const uint8_t *request, size_t request_len);
 
     void setLowLatency(bool enable = true);
 
+    // Активное ожидание в poll(): до spin_us микросекунд крутимся на
+    // проверке ::poll(fd, 0), затем уходим в обычный ::poll. fd остается
+    // блокирующим: read() после POLLIN не ждет, а write() не теряет данные.
+    // 0 - выключить
+    void setBusyPoll(uint32_t spin_us) { m_spin_us = spin_us; }
+    uint32_t busyPoll() const { return m_spin_us; }
+
+    // Таймер задержки FTDI (latency_timer в sysfs, 1..255 мс)
+    bool setLatencyTimer(uint8_t ms);
+
+    // Сбор статистики задержки poll() -> read(). Окно на
+    // USERIAL_LATENCY_WINDOW отсчетов выделяется только при включении
+    void enableLatencyStats(bool enable = true);
+    uSerialLatencyStats latencyStats() const;
+
+    // Пакетный режим: посылкой считается пачка байт, после которой линия
+    // молчит не меньше interbyte_us (Modbus RTU, SBUS). 0 - выключить.
+    // Паузу отмеряет таймер ppoll внутри readPacket; VMIN/VTIME на fd не
+    // меняются, остальные read() по-прежнему возвращаются сразу.
+    // max_packet - буфер посылки для dispatch(): длиннее делится на части
+    bool setPacketMode(uint32_t interbyte_us, size_t max_packet = USERIAL_PACKET_MAX);
+    uint32_t packetGap() const { return m_packet_gap_us; }
+
+    // Чтение одной посылки; timestamp_us - время прихода последнего байта
+    // (uClock::nowUs()). timeout_ms - ожидание первого байта, -1 - бесконечно.
+    // Остаток окна acquireRead отдается первым, отдельной посылкой
+    size_t readPacket(uint8_t *buffer, size_t length, int timeout_ms = -1,
+                      uint64_t *timestamp_us = nullptr);
+
 private:
     int m_fd;
     bool m_is_external;
+    unsigned long m_baudrate;
+    uint32_t m_packet_gap_us;
+    size_t m_packet_max;
+    std::vector<uint8_t> m_packet_buf;
+
+    uint32_t m_spin_us;
+    bool m_latency_enabled;
+    uint64_t m_ready_ns;
+    std::vector<uint32_t> m_latency_samples;
+    uint32_t m_latency_count;
+    uint32_t m_spin_hits;
+    uint32_t m_blocking_waits;
+
+    void markReady(bool spin);
+    void recordLatency();
+
+#if defined(__linux__) && HAS_TERMIOS2
+    // Последнее примененное состояние termios2, чтобы не делать TCGETS2 на каждую смену скорости
+    struct termios2 m_tio2;
+    bool m_tio2_valid;
+#endif
+    void cacheTermios();
 
     bool configureSerial(unsigned long baudrate);
     speed_t getBaudRateConstant(unsigned long baudrate);
@@ -131,6 +227,64 @@ private:
     bool setCustomBaudrateMacOS(unsigned long baudrate);
 #endif // __APPLE__
 };
+
+// Горячие вызовы определены здесь, а не в serial.cpp: DirectStream<uSerial>
+// вызывает их без vtable и может встроить вместе с проверками
+inline int uSerial::available() const
+{
+    if (m_fd < 0)
+        return 0;
+
+    int bytes_available = 0;
+    ioctl(m_fd, FIONREAD, &bytes_available);
+    return bytes_available + (int)stagedRead();
+}
+
+inline size_t uSerial::read(uint8_t *buffer, size_t length)
+{
+    if (m_fd < 0 || !buffer || length == 0)
+        return 0;
+    if (stagedRead() > 0)
+    {
+        size_t staged = takeStaged(buffer, length);
+        STREAM_STAT_DELIVERED(staged);
+        return staged;
+    }
+    STREAM_TRACE_START(trace_started);
+    ssize_t n = ::read(m_fd, buffer, length);
+    STREAM_TRACE_SPAN(TRACE_SERIAL_READ, trace_started, m_fd, n);
+    STREAM_STAT_ADD(STREAM_STAT_SYSCALLS, 1);
+    if (n <= 0)
+        return 0;
+    if (m_ready_ns != 0)
+        recordLatency();
+    STREAM_STAT_DELIVERED(n);
+    return (size_t)n;
+}
+
+inline size_t uSerial::write(const uint8_t *buffer, size_t length)
+{
+    if (m_fd < 0 || !buffer || length == 0)
+        return 0;
+    STREAM_STAT_START(started);
+    STREAM_TRACE_START(trace_started);
+    ssize_t n = ::write(m_fd, buffer, length);
+    STREAM_TRACE_SPAN(TRACE_SERIAL_WRITE, trace_started, m_fd, n);
+    STREAM_STAT_WRITE_DONE(started);
+    STREAM_STAT_ADD(STREAM_STAT_SYSCALLS, 1);
+    if (n <= 0)
+        return 0;
+    STREAM_STAT_ADD(STREAM_STAT_OPS_OUT, 1);
+    STREAM_STAT_ADD(STREAM_STAT_BYTES_OUT, n);
+    if ((size_t)n < length)
+        STREAM_STAT_ADD(STREAM_STAT_PARTIAL_WRITES, 1);
+    return (size_t)n;
+}
+
+inline bool uSerial::isOpen() const
+{
+    return m_fd >= 0;
+}
 #endif // ARDUINO
 #endif // FURI_OS
 
@@ -213,7 +367,7 @@ public:
         if (!m_stream)
             return false;
         unsigned long start = millis();
-        while (millis() - start < timeout_ms)
+        while (millis() - start < (unsigned long)timeout_ms)
         {
             if (available() > 0)
                 return true;
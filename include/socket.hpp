@@ -19,9 +19,22 @@ public:
     size_t read(uint8_t* buffer, size_t length) override;
     size_t write(uint8_t byte) override;
     size_t write(const uint8_t* buffer, size_t length) override;
+    size_t writev(const struct iovec* iov, int iovcnt) override;
+    size_t readv(const struct iovec* iov, int iovcnt) override;
+    // Окно чтения - очередь приема, перенесенная в m_rx_stage под короткой
+    // блокировкой; m_queue_mutex между acquireRead и releaseRead не держится.
+    // Окно записи - полезная нагрузка будущего фрейма
+    sbu_t acquireRead(size_t min = 1) override;
+    void releaseRead(size_t n) override;
+    sbu_t acquireWrite(size_t min) override;
+    size_t commitWrite(size_t n) override;
     void flush() override;
     bool poll(int timeout_ms) override;
     bool isOpen() const override;
+    // Данные принимает фоновый поток, поэтому наружу отдается не сокет,
+    // а pipe, который читаем, пока очередь приема не пуста. Создается
+    // при первом вызове: без цикла событий WebSocket не тратит на него fd
+    int pollFd() const override;
 
 private:
     int m_fd;
@@ -32,11 +45,23 @@ private:
     
     mutable std::mutex m_queue_mutex;
     std::vector<uint8_t> m_recv_queue;
+    std::vector<uint8_t> m_tx_frame;
+    mutable int m_notify_pipe[2];
+    mutable bool m_notify_pending;
+
+    // Окно acquireRead, затем очередь; без учета в статистике
+    size_t take(uint8_t* buffer, size_t length);
+
+    // Вызываются под m_queue_mutex
+    void notifyReadable() const;
+    void clearReadable();
     
     bool parseWebSocketURI(const std::string& uri, std::string& host, int& port, std::string& path);
     bool performWebSocketHandshake(const std::string& host, const std::string& path);
     std::string generateWebSocketKey();
     void buildWebSocketFrame(const uint8_t* data, size_t len, std::vector<uint8_t>& frame, bool binary = true);
+    void buildWebSocketFrame(const struct iovec* iov, int iovcnt, std::vector<uint8_t>& frame, bool binary = true);
+    size_t sendFrame(const std::vector<uint8_t>& frame, size_t payload_len);
     void sendWebSocketCloseFrame();
     void processWebSocketData(const uint8_t* data, size_t len);
     void readerThread();
@@ -0,0 +1,300 @@
+#pragma once
+
+// Счетчики производительности потоков.
+//
+// Включаются сборкой с -DSTREAM_STATS=1. Без флага макросы STREAM_STAT_*
+// раскрываются в ничто, а у uStream нет ни полей, ни методов статистики.
+// Все счетчики - relaxed atomics: запись из потока чтения WebSocket и
+// снимок из любого другого потока не требуют блокировок.
+//
+// ops_in/bytes_in у всех потоков считаются в одной точке - при выдаче
+// данных вызывающему (read/readv/readPacket, releaseRead, вызов onData/
+// onMessage), а не при приеме из транспорта во внутренний буфер.
+
+#ifndef STREAM_STATS
+#define STREAM_STATS 0
+#endif
+
+#if STREAM_STATS
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+#include "common.h"
+#include <chrono>
+#include <string>
+
+enum uStreamStat
+{
+    STREAM_STAT_BYTES_IN = 0,
+    STREAM_STAT_BYTES_OUT,
+    STREAM_STAT_OPS_IN,
+    STREAM_STAT_OPS_OUT,
+    STREAM_STAT_SYSCALLS,
+    STREAM_STAT_PARTIAL_WRITES,
+    STREAM_STAT_FRAMES,
+    STREAM_STAT_DROPPED,
+    STREAM_STAT_RECONNECTS,
+    STREAM_STAT_BLOCKED_NS,
+    STREAM_STAT_COUNT
+};
+
+static inline const char *stream_stat_name(int stat)
+{
+    static const char *const names[STREAM_STAT_COUNT] = {
+        "bytes_in", "bytes_out", "ops_in", "ops_out", "syscalls",
+        "partial_writes", "frames", "dropped", "reconnects", "blocked_ns"};
+    return (stat >= 0 && stat < STREAM_STAT_COUNT) ? names[stat] : "?";
+}
+
+static inline uint64_t stream_stat_now_ns()
+{
+#if !defined(ARDUINO) && !defined(FURI_OS)
+    return uClock::realNs();
+#else
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+struct uHistogramSnapshot
+{
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+    uint64_t p50;
+    uint64_t p90;
+    uint64_t p99;
+    uint64_t p999;
+};
+
+// Лог-линейная гистограмма в духе HDR: 4 корзины на октаву (точность ~25%),
+// весь диапазон uint64_t в 252 счетчиках, запись - один fetch_add
+class uHistogram
+{
+public:
+    static const int SUB_BITS = 2;
+    static const int SUB_COUNT = 1 << SUB_BITS;
+    static const int BUCKETS = (64 - SUB_BITS) * SUB_COUNT + SUB_COUNT;
+
+    uHistogram()
+    {
+        for (int i = 0; i < BUCKETS; i++)
+            m_buckets[i].store(0, std::memory_order_relaxed);
+    }
+
+    inline void record(uint64_t value)
+    {
+        m_buckets[index(value)].fetch_add(1, std::memory_order_relaxed);
+        m_sum.fetch_add(value, std::memory_order_relaxed);
+        uint64_t max = m_max.load(std::memory_order_relaxed);
+        while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    uHistogramSnapshot snapshot() const
+    {
+        uint64_t counts[BUCKETS];
+        uint64_t total = 0;
+        for (int i = 0; i < BUCKETS; i++)
+        {
+            counts[i] = m_buckets[i].load(std::memory_order_relaxed);
+            total += counts[i];
+        }
+
+        uHistogramSnapshot s;
+        s.count = total;
+        s.sum = m_sum.load(std::memory_order_relaxed);
+        s.max = m_max.load(std::memory_order_relaxed);
+        s.p50 = percentile(counts, total, 500);
+        s.p90 = percentile(counts, total, 900);
+        s.p99 = percentile(counts, total, 990);
+        s.p999 = percentile(counts, total, 999);
+        return s;
+    }
+
+    static inline int index(uint64_t value)
+    {
+        if (value < (uint64_t)SUB_COUNT)
+            return (int)value;
+        int msb = 63 - __builtin_clzll(value);
+        int sub = (int)(value >> (msb - SUB_BITS)) & (SUB_COUNT - 1);
+        return (msb - SUB_BITS + 1) * SUB_COUNT + sub;
+    }
+
+    static inline uint64_t lowerBound(int index)
+    {
+        if (index < SUB_COUNT)
+            return (uint64_t)index;
+        int msb = index / SUB_COUNT + SUB_BITS - 1;
+        uint64_t sub = (uint64_t)(index % SUB_COUNT);
+        return (SUB_COUNT + sub) << (msb - SUB_BITS);
+    }
+
+private:
+    std::atomic<uint64_t> m_buckets[BUCKETS];
+    std::atomic<uint64_t> m_sum{0};
+    std::atomic<uint64_t> m_max{0};
+
+    // per_mille - 500 для p50, 999 для p99.9; результат - середина корзины
+    static uint64_t percentile(const uint64_t *counts, uint64_t total, uint64_t per_mille)
+    {
+        if (total == 0)
+            return 0;
+        uint64_t target = (total * per_mille + 999) / 1000;
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKETS; i++)
+        {
+            seen += counts[i];
+            if (seen >= target)
+            {
+                uint64_t low = lowerBound(i);
+                uint64_t high = (i + 1 < BUCKETS) ? lowerBound(i + 1) : low;
+                return low + (high - low) / 2;
+            }
+        }
+        return 0;
+    }
+};
+
+struct uStreamStatsSnapshot
+{
+    uint64_t counters[STREAM_STAT_COUNT];
+    uHistogramSnapshot write_latency_ns;
+    uHistogramSnapshot read_wait_ns;
+};
+
+class uStreamStats
+{
+public:
+    uStreamStats()
+    {
+        for (int i = 0; i < STREAM_STAT_COUNT; i++)
+            m_counters[i].store(0, std::memory_order_relaxed);
+    }
+
+    inline void add(uStreamStat stat, uint64_t value = 1)
+    {
+        m_counters[stat].fetch_add(value, std::memory_order_relaxed);
+    }
+
+    inline void recordWrite(uint64_t ns) { m_write_latency.record(ns); }
+
+    inline void recordWait(uint64_t ns)
+    {
+        m_read_wait.record(ns);
+        add(STREAM_STAT_BLOCKED_NS, ns);
+    }
+
+    // Выдача n байт вызывающему: одна операция чтения
+    inline void delivered(uint64_t n)
+    {
+        if (n == 0)
+            return;
+        add(STREAM_STAT_OPS_IN);
+        add(STREAM_STAT_BYTES_IN, n);
+    }
+
+    // Первое открытие - не переподключение
+    inline void noteOpen()
+    {
+        if (m_opened.exchange(true, std::memory_order_relaxed))
+            add(STREAM_STAT_RECONNECTS);
+    }
+
+    uStreamStatsSnapshot snapshot() const
+    {
+        uStreamStatsSnapshot s;
+        for (int i = 0; i < STREAM_STAT_COUNT; i++)
+            s.counters[i] = m_counters[i].load(std::memory_order_relaxed);
+        s.write_latency_ns = m_write_latency.snapshot();
+        s.read_wait_ns = m_read_wait.snapshot();
+        return s;
+    }
+
+    // {"bytes_in":..,...,"write_latency_ns":{"count":..,"p50":..}}
+    static std::string toJson(const uStreamStatsSnapshot &s)
+    {
+        std::string out = "{";
+        char buf[192];
+        for (int i = 0; i < STREAM_STAT_COUNT; i++)
+        {
+            snprintf(buf, sizeof(buf), "\"%s\":%llu,", stream_stat_name(i),
+                     (unsigned long long)s.counters[i]);
+            out += buf;
+        }
+        appendJson(out, "write_latency_ns", s.write_latency_ns);
+        out += ",";
+        appendJson(out, "read_wait_ns", s.read_wait_ns);
+        out += "}";
+        return out;
+    }
+
+    // Текстовый формат Prometheus, stream - значение метки stream="..."
+    static std::string toPrometheus(const uStreamStatsSnapshot &s, const char *stream)
+    {
+        std::string out;
+        char buf[256];
+        for (int i = 0; i < STREAM_STAT_COUNT; i++)
+        {
+            snprintf(buf, sizeof(buf), "ustream_%s_total{stream=\"%s\"} %llu\n",
+                     stream_stat_name(i), stream, (unsigned long long)s.counters[i]);
+            out += buf;
+        }
+        appendPrometheus(out, "ustream_write_latency_ns", stream, s.write_latency_ns);
+        appendPrometheus(out, "ustream_read_wait_ns", stream, s.read_wait_ns);
+        return out;
+    }
+
+private:
+    std::atomic<uint64_t> m_counters[STREAM_STAT_COUNT];
+    std::atomic<bool> m_opened{false};
+    uHistogram m_write_latency;
+    uHistogram m_read_wait;
+
+    static void appendJson(std::string &out, const char *name, const uHistogramSnapshot &h)
+    {
+        char buf[256];
+        snprintf(buf, sizeof(buf),
+                 "\"%s\":{\"count\":%llu,\"sum\":%llu,\"max\":%llu,"
+                 "\"p50\":%llu,\"p90\":%llu,\"p99\":%llu,\"p999\":%llu}",
+                 name, (unsigned long long)h.count, (unsigned long long)h.sum,
+                 (unsigned long long)h.max, (unsigned long long)h.p50,
+                 (unsigned long long)h.p90, (unsigned long long)h.p99,
+                 (unsigned long long)h.p999);
+        out += buf;
+    }
+
+    static void appendPrometheus(std::string &out, const char *name, const char *stream,
+                                 const uHistogramSnapshot &h)
+    {
+        static const char *const quantiles[] = {"0.5", "0.9", "0.99", "0.999"};
+        const uint64_t values[] = {h.p50, h.p90, h.p99, h.p999};
+        char buf[256];
+        for (int i = 0; i < 4; i++)
+        {
+            snprintf(buf, sizeof(buf), "%s{stream=\"%s\",quantile=\"%s\"} %llu\n",
+                     name, stream, quantiles[i], (unsigned long long)values[i]);
+            out += buf;
+        }
+        snprintf(buf, sizeof(buf), "%s_sum{stream=\"%s\"} %llu\n%s_count{stream=\"%s\"} %llu\n",
+                 name, stream, (unsigned long long)h.sum,
+                 name, stream, (unsigned long long)h.count);
+        out += buf;
+    }
+};
+
+#define STREAM_STAT_ADD(stat, value) m_stats.add((stat), (value))
+#define STREAM_STAT_DELIVERED(n) m_stats.delivered(n)
+#define STREAM_STAT_OPEN() m_stats.noteOpen()
+#define STREAM_STAT_START(var) uint64_t var = stream_stat_now_ns()
+#define STREAM_STAT_WRITE_DONE(var) m_stats.recordWrite(stream_stat_now_ns() - (var))
+#define STREAM_STAT_WAIT_DONE(var) m_stats.recordWait(stream_stat_now_ns() - (var))
+#else
+#define STREAM_STAT_ADD(stat, value) ((void)0)
+#define STREAM_STAT_DELIVERED(n) ((void)0)
+#define STREAM_STAT_OPEN() ((void)0)
+#define STREAM_STAT_START(var) ((void)0)
+#define STREAM_STAT_WRITE_DONE(var) ((void)0)
+#define STREAM_STAT_WAIT_DONE(var) ((void)0)
+#endif // STREAM_STATS
@@ -5,14 +5,125 @@
 #include <string.h>
 #include <algorithm>
 #include <memory>
+#include <vector>
+#include <functional>
 #include "common.h"
 #include "sbu.h"
+#include "stats.hpp"
+#include "trace.hpp"
+
+#if !defined(ARDUINO) && !defined(FURI_OS)
+#include <sys/uio.h>
+#else
+// Совместимая с POSIX структура для платформ без sys/uio.h
+struct iovec
+{
+    void *iov_base;
+    size_t iov_len;
+};
+#endif
 
 class uStream
 {
 private:
     bool m_is_writable = true;
 
+protected:
+#if STREAM_STATS
+    uStreamStats m_stats;
+#endif
+
+    // Промежуточные буферы для acquire*/commit* по умолчанию
+    std::vector<uint8_t> m_rx_stage;
+    size_t m_rx_stage_head = 0;
+    std::vector<uint8_t> m_tx_stage;
+    // Копия окна для callback'ов dispatch()
+    std::vector<uint8_t> m_dispatch_buf;
+
+    size_t stagedRead() const { return m_rx_stage.size() - m_rx_stage_head; }
+
+    // Выдать байты, оставшиеся в m_rx_stage после acquireRead/releaseRead
+    size_t takeStaged(uint8_t *buffer, size_t length)
+    {
+        size_t n = std::min(length, stagedRead());
+        if (n == 0)
+            return 0;
+        memcpy(buffer, m_rx_stage.data() + m_rx_stage_head, n);
+        releaseStaged(n);
+        return n;
+    }
+
+    void releaseStaged(size_t n)
+    {
+        m_rx_stage_head += std::min(n, stagedRead());
+        if (m_rx_stage_head == m_rx_stage.size())
+        {
+            m_rx_stage.clear();
+            m_rx_stage_head = 0;
+        }
+    }
+
+    // Место под еще length байт в конце m_rx_stage
+    uint8_t *growStage(size_t length)
+    {
+        if (m_rx_stage_head > 0)
+        {
+            m_rx_stage.erase(m_rx_stage.begin(), m_rx_stage.begin() + m_rx_stage_head);
+            m_rx_stage_head = 0;
+        }
+        size_t old = m_rx_stage.size();
+        m_rx_stage.resize(old + length);
+        return m_rx_stage.data() + old;
+    }
+
+    static sbu_t makeView(uint8_t *ptr, size_t length)
+    {
+        sbu_t view;
+        sbu_init(&view, ptr, ptr ? ptr + length : nullptr);
+        return view;
+    }
+
+public:
+    typedef std::function<void(const uint8_t *data, size_t length)> DataCallback;
+    typedef std::function<void(std::function<void()> task)> Executor;
+
+private:
+    DataCallback m_on_data;
+    Executor m_on_data_executor;
+    DataCallback m_on_message;
+    Executor m_on_message_executor;
+
+    static void deliver(const DataCallback &callback, const Executor &executor,
+                        const uint8_t *data, size_t length)
+    {
+        if (!callback)
+            return;
+        if (!executor)
+        {
+            callback(data, length);
+            return;
+        }
+        // Окно данных живет только на время вызова, исполнителю нужна копия
+        std::shared_ptr<std::vector<uint8_t>> copy =
+            std::make_shared<std::vector<uint8_t>>(data, data + length);
+        DataCallback fn = callback;
+        executor([fn, copy]()
+                 { fn(copy->data(), copy->size()); });
+    }
+
+protected:
+    bool hasCallbacks() const { return m_on_data || m_on_message; }
+
+    void dispatchData(const uint8_t *data, size_t length)
+    {
+        deliver(m_on_data, m_on_data_executor, data, length);
+    }
+
+    void dispatchMessage(const uint8_t *data, size_t length)
+    {
+        deliver(m_on_message, m_on_message_executor, data, length);
+    }
+
 public:
     uStream() = default;
     virtual ~uStream() = default;
@@ -32,12 +143,94 @@ public:
     virtual size_t write(uint8_t byte) = 0;
     virtual size_t write(const uint8_t *buffer, size_t length) = 0;
 
+    // Scatter/gather: по умолчанию цикл по сегментам, транспорты с
+    // нативной поддержкой (uSerial - ::writev, WebSocket - один фрейм)
+    // переопределяют. Возвращают число переданных байт, останавливаются
+    // на первом неполном сегменте
+    virtual size_t writev(const struct iovec *iov, int iovcnt)
+    {
+        size_t total = 0;
+        for (int i = 0; i < iovcnt; i++)
+        {
+            size_t len = iov[i].iov_len;
+            if (len == 0)
+                continue;
+            size_t written = write(static_cast<const uint8_t *>(iov[i].iov_base), len);
+            total += written;
+            if (written != len)
+                break;
+        }
+        return total;
+    }
+
+    virtual size_t readv(const struct iovec *iov, int iovcnt)
+    {
+        size_t total = 0;
+        for (int i = 0; i < iovcnt; i++)
+        {
+            size_t len = iov[i].iov_len;
+            if (len == 0)
+                continue;
+            size_t bytes_read = read(static_cast<uint8_t *>(iov[i].iov_base), len);
+            total += bytes_read;
+            if (bytes_read != len)
+                break;
+        }
+        return total;
+    }
+
+    // Заимствованное чтение без копирования в буфер вызывающего:
+    // окно (ptr..end) во внутренний буфер потока, не короче min байт,
+    // либо пустое (ptr == nullptr), если столько данных пока нет.
+    // Окно действительно до releaseRead(n), который потребляет n байт.
+    // По умолчанию данные один раз копируются в m_rx_stage
+    virtual sbu_t acquireRead(size_t min = 1)
+    {
+        if (min == 0)
+            min = 1;
+        if (stagedRead() < min)
+        {
+            int bytes_available = available();
+            if (bytes_available > 0)
+            {
+                uint8_t *dst = growStage((size_t)bytes_available);
+                size_t bytes_read = read(dst, (size_t)bytes_available);
+                m_rx_stage.resize(m_rx_stage.size() - (size_t)bytes_available + bytes_read);
+            }
+            if (stagedRead() < min)
+                return makeView(nullptr, 0);
+        }
+        return makeView(m_rx_stage.data() + m_rx_stage_head, stagedRead());
+    }
+
+    virtual void releaseRead(size_t n)
+    {
+        releaseStaged(n);
+    }
+
+    // Заимствованная запись: окно не меньше min байт для формирования
+    // данных на месте, commitWrite(n) отправляет первые n из них
+    virtual sbu_t acquireWrite(size_t min)
+    {
+        if (m_tx_stage.size() < min)
+            m_tx_stage.resize(min);
+        return makeView(m_tx_stage.data(), m_tx_stage.size());
+    }
+
+    virtual size_t commitWrite(size_t n)
+    {
+        n = std::min(n, m_tx_stage.size());
+        return n ? write(m_tx_stage.data(), n) : 0;
+    }
+
     inline bool readBytes(uint8_t *buffer, size_t length, uint32_t timeout_ms = 1000)
     {
         if (!buffer)
             return false;
 
         size_t index = 0;
+        // millis(), а не micros(): разность 32-битных микросекунд
+        // переполняется через ~71 минуту и длинный таймаут не наступил бы
         uint32_t start_time = millis();
         while (index < length)
         {
@@ -47,7 +240,7 @@ public:
             }
             else
             {
-                if (millis() - start_time > timeout_ms)
+                if (millis() - start_time >= timeout_ms)
                     break;
                 usleep(100);
             }
@@ -106,16 +299,78 @@ public:
 
     inline size_t println(const char *str = "")
     {
-        size_t written = writeString(str);
-        written += write('\r');
-        written += write('\n');
-        return written;
+        static const char crlf[] = "\r\n";
+        struct iovec iov[2];
+        iov[0].iov_base = const_cast<char *>(str ? str : "");
+        iov[0].iov_len = str ? strlen(str) : 0;
+        iov[1].iov_base = const_cast<char *>(crlf);
+        iov[1].iov_len = 2;
+        return writev(iov, 2);
     }
 
     virtual void flush() = 0;
     virtual bool poll(int timeout_ms = 0) = 0;
     virtual bool isOpen() const = 0;
 
+    // Push-модель вместо опроса available(). onData получает новые байты
+    // пачкой, onMessage - целое сообщение (фрейм WebSocket, пакет uSerial
+    // в пакетном режиме). Вызов идет прямо из источника: поток чтения
+    // WebSocket, dispatch() или цикл событий; с executor - задачей в нем.
+    // Данные, отданные callback'ам, в очередь чтения не попадают.
+    // Регистрировать до open()/begin()
+    void onData(DataCallback callback, Executor executor = nullptr)
+    {
+        m_on_data = callback;
+        m_on_data_executor = executor;
+    }
+
+    void onMessage(DataCallback callback, Executor executor = nullptr)
+    {
+        m_on_message = callback;
+        m_on_message_executor = executor;
+    }
+
+    // Забрать все пришедшее и раздать callback'ам, не дольше timeout_ms
+    // ожидания. Для потоков без собственного потока чтения (uSerial).
+    // Без границ сообщений по умолчанию вызывается только onData
+    virtual size_t dispatch(int timeout_ms = 0)
+    {
+        if (!hasCallbacks())
+            return 0;
+
+        // Сначала уже принятое: poll() у WebSocket смотрит на сокет, а не
+        // на очередь, куда фреймы успел сложить поток чтения
+        sbu_t view = acquireRead(1);
+        if (!view.ptr)
+        {
+            if (timeout_ms == 0 || !poll(timeout_ms))
+                return 0;
+            view = acquireRead(1);
+            if (!view.ptr)
+                return 0;
+        }
+
+        // Окно отпускаем до вызова callback'а: ему можно читать поток и
+        // отвечать в него. Буфер копии переиспользуется между вызовами
+        size_t length = sbu_left(&view);
+        std::vector<uint8_t> data;
+        data.swap(m_dispatch_buf);
+        data.assign(view.ptr, view.ptr + length);
+        releaseRead(length);
+        dispatchData(data.data(), length);
+        m_dispatch_buf.swap(data);
+        return length;
+    }
+
+#if STREAM_STATS
+    // Снимок счетчиков; uStreamStats::toJson/toPrometheus для выгрузки
+    uStreamStatsSnapshot stats() const { return m_stats.snapshot(); }
+#endif
+
+    // fd, который становится читаемым (POLLIN), когда у потока есть данные,
+    // для внешних циклов событий. -1 - поток так не умеет
+    virtual int pollFd() const { return -1; }
+
     virtual bool isReadable() const
     {
         return isOpen() && (available() > 0);
@@ -0,0 +1,158 @@
+#pragma once
+
+// Бинарная трассировка горячих путей.
+//
+// Включается сборкой с -DSTREAM_TRACE=1, иначе макросы STREAM_TRACE_*
+// раскрываются в ничто. Событие - 32-байтовая запись (время, id, три
+// аргумента) в кольцо своего потока: без блокировок и форматирования,
+// запись стоит одного чтения часов и нескольких store.
+//
+//   uTrace::init("/var/tmp/stream.trace");   // файл переживает падение
+//   uTrace::installCrashHandler();
+//   ...
+//   trace_decode /var/tmp/stream.trace       // tools/trace_decode.cpp
+//
+// Кольца лежат в mmap(MAP_SHARED) файла, поэтому после аварийного
+// завершения последние события остаются в файле без всякого сброса.
+
+#ifndef STREAM_TRACE
+#define STREAM_TRACE 0
+#endif
+
+#if STREAM_TRACE && !defined(ARDUINO) && !defined(FURI_OS)
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include <atomic>
+#include "common.h"
+
+#define UTRACE_MAGIC "USTRACE1"
+#define UTRACE_VERSION 1
+#define UTRACE_MAX_EVENTS 256
+#define UTRACE_NAME_LEN 32
+
+enum uTraceEvent
+{
+    TRACE_NONE = 0,
+    TRACE_CRASH,         // a0 - номер сигнала
+    TRACE_MARK,          // пользовательская метка, аргументы произвольные
+    TRACE_SERIAL_READ = 16, // a0 - fd, a1 - результат read, a2 - нс в вызове
+    TRACE_SERIAL_WRITE,  // a0 - fd, a1 - результат write, a2 - нс в вызове
+    TRACE_SERIAL_POLL,   // a0 - fd, a1 - готов, a2 - нс ожидания
+    TRACE_SERIAL_PACKET, // a0 - fd, a1 - байт в пакете, a2 - нс сборки
+    TRACE_WS_WAIT = 32,  // a0 - fd, a1 - результат select, a2 - нс ожидания
+    TRACE_WS_RECV,       // a0 - fd, a1 - результат recv, a2 - нс в вызове
+    TRACE_WS_FRAME,      // a0 - opcode, a1 - длина полезной нагрузки, a2 - длина кадра
+    TRACE_WS_DROP,       // a1 - отброшено байт, a2 - размер очереди
+    TRACE_WS_SEND,       // a0 - fd, a1 - результат send, a2 - нс в вызове
+    TRACE_USER = 128,    // свои события: TRACE_USER + n, имя через defineEvent
+};
+
+struct uTraceRecord
+{
+    uint64_t ts_ns;
+    uint16_t event;
+    uint16_t reserved;
+    uint32_t a0;
+    uint64_t a1;
+    uint64_t a2;
+};
+
+// Заголовок файла трассы; за ним ring_count колец по ring_stride байт
+struct uTraceHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t ring_count;
+    uint32_t ring_capacity;
+    uint64_t ring_stride;
+    uint64_t rings_offset;
+    int64_t realtime_offset_ns; // CLOCK_REALTIME - ts_ns на момент init
+    uint32_t pid;
+    std::atomic<uint32_t> rings_used;
+    char names[UTRACE_MAX_EVENTS][UTRACE_NAME_LEN];
+};
+
+// Кольцо одного потока. Писатель единственный, head растет монотонно,
+// запись i лежит в records[i & (capacity - 1)]
+struct alignas(64) uTraceRing
+{
+    uint32_t tid;
+    uint32_t capacity;
+    std::atomic<uint64_t> head;
+    char thread_name[16];
+    uTraceRecord records[1];
+};
+
+class uTrace
+{
+public:
+    // path == nullptr - анонимная память, сохранить можно через dump().
+    // rings - сколько потоков могут писать, ring_capacity - степень двойки
+    static bool init(const char *path = nullptr, uint32_t rings = 16, uint32_t ring_capacity = 8192);
+
+    // Вызывать, когда пишущие потоки уже остановлены
+    static void shutdown();
+
+    static bool enabled() { return s_header.load(std::memory_order_relaxed) != nullptr; }
+
+    // Имя события для декодера (id < UTRACE_MAX_EVENTS)
+    static void defineEvent(uint16_t event, const char *name);
+
+    // Записать кольца в файл того же формата
+    static bool dump(const char *path);
+
+    // SIGSEGV/SIGBUS/SIGILL/SIGFPE/SIGABRT: событие TRACE_CRASH (если упавший
+    // поток уже писал в трассу), msync, затем стандартная обработка сигнала
+    static void installCrashHandler();
+
+    // Текстовый вид трассы, все потоки по возрастанию времени
+    static bool decode(const char *path, FILE *out);
+
+    // Реальное время даже при виртуальных uClock
+    static inline uint64_t now() { return uClock::realNs(); }
+
+    static inline void record(uint16_t event, uint32_t a0 = 0, uint64_t a1 = 0, uint64_t a2 = 0)
+    {
+        uTraceRing *ring = t_ring;
+        if (t_generation != s_generation.load(std::memory_order_acquire))
+            ring = attach();
+        if (ring)
+            write(ring, event, a0, a1, a2);
+    }
+
+private:
+    static std::atomic<uTraceHeader *> s_header;
+    // Растет при каждом init/shutdown: кольцо потока из прошлого отображения
+    // не совпадет с новым, даже если mmap вернул тот же адрес
+    static std::atomic<uint32_t> s_generation;
+    static size_t s_size;
+    static inline thread_local uTraceRing *t_ring = nullptr;
+    static inline thread_local uint32_t t_generation = 0;
+
+    static uTraceRing *attach();
+    static void onCrash(int sig);
+
+    static inline void write(uTraceRing *ring, uint16_t event, uint32_t a0, uint64_t a1, uint64_t a2)
+    {
+        uint64_t head = ring->head.load(std::memory_order_relaxed);
+        uTraceRecord &rec = ring->records[head & (ring->capacity - 1)];
+        rec.ts_ns = now();
+        rec.event = event;
+        rec.reserved = 0;
+        rec.a0 = a0;
+        rec.a1 = a1;
+        rec.a2 = a2;
+        ring->head.store(head + 1, std::memory_order_release);
+    }
+};
+
+#define STREAM_TRACE_EVENT(event, a0, a1, a2) uTrace::record((event), (uint32_t)(a0), (uint64_t)(a1), (uint64_t)(a2))
+#define STREAM_TRACE_START(var) uint64_t var = uTrace::now()
+#define STREAM_TRACE_SPAN(event, var, a0, a1) uTrace::record((event), (uint32_t)(a0), (uint64_t)(a1), uTrace::now() - (var))
+#else
+#define STREAM_TRACE_EVENT(event, a0, a1, a2) ((void)0)
+#define STREAM_TRACE_START(var) ((void)0)
+#define STREAM_TRACE_SPAN(event, var, a0, a1) ((void)0)
+#endif // STREAM_TRACE
@@ -0,0 +1,136 @@
+#include "async.hpp"
+#include <errno.h>
+
+#if defined(__cpp_impl_coroutine) && !defined(ARDUINO) && !defined(FURI_OS)
+
+// Без fd операцию приходится опрашивать по времени
+#define ASYNC_FALLBACK_POLL_MS 1
+
+void uAsyncOp::arm(uEventLoop *owner, std::coroutine_handle<> h, uint32_t timeout_ms)
+{
+    loop = owner;
+    handle = h;
+    timed_out = false;
+    failed = false;
+    has_deadline = timeout_ms > 0;
+    deadline = millis() + timeout_ms;
+    owner->add(this);
+}
+
+void uEventLoop::watch(uStream &stream)
+{
+    std::unique_ptr<WatchOp> op(new WatchOp());
+    op->loop = this;
+    op->stream = &stream;
+    op->fd = stream.pollFd();
+    op->progress = &WatchOp::step;
+    add(op.get());
+    m_watches.push_back(std::move(op));
+}
+
+void uEventLoop::unwatch(uStream &stream)
+{
+    // Объект может быть в текущем проходе runOnce, поэтому только
+    // помечаем: step() завершит его, а память освободится после прохода
+    for (auto &op : m_watches)
+    {
+        if (op->stream == &stream)
+        {
+            op->stream = nullptr;
+            op->fd = -1;
+        }
+    }
+}
+
+void uEventLoop::run()
+{
+    m_stop = false;
+    while (!m_stop && runOnce(-1))
+    {
+    }
+}
+
+bool uEventLoop::runOnce(int timeout_ms)
+{
+    if (m_ops.empty())
+        return false;
+
+    // Ожидающие переезжают в m_scan: resume() может добавить новые в m_ops
+    m_scan.swap(m_ops);
+    m_pfds.clear();
+
+    uint32_t now = millis();
+    for (uAsyncOp *op : m_scan)
+    {
+        op->pfd_index = -1;
+        if (op->fd >= 0)
+        {
+            struct pollfd pfd;
+            pfd.fd = op->fd;
+            pfd.events = op->events;
+            pfd.revents = 0;
+            op->pfd_index = (int)m_pfds.size();
+            m_pfds.push_back(pfd);
+        }
+        else if (op->progress)
+        {
+            if (timeout_ms < 0 || timeout_ms > ASYNC_FALLBACK_POLL_MS)
+                timeout_ms = ASYNC_FALLBACK_POLL_MS;
+        }
+
+        if (op->has_deadline)
+        {
+            int left = (int32_t)(op->deadline - now) > 0 ? (int)(op->deadline - now) : 0;
+            if (timeout_ms < 0 || left < timeout_ms)
+                timeout_ms = left;
+        }
+    }
+
+    if (!m_pfds.empty() || timeout_ms > 0)
+    {
+        int ret = ::poll(m_pfds.data(), m_pfds.size(), timeout_ms);
+        if (ret < 0 && errno != EINTR)
+            LOG_ERROR_F("uEventLoop poll failed: %s", strerror(errno));
+    }
+
+    now = millis();
+    for (size_t i = 0; i < m_scan.size(); i++)
+    {
+        uAsyncOp *op = m_scan[i];
+        short revents = op->pfd_index < 0 ? 0 : m_pfds[op->pfd_index].revents;
+        bool ready = op->pfd_index < 0 ? op->progress != nullptr : revents != 0;
+
+        bool complete = ready && op->progress && op->progress(op);
+        if (!complete && (revents & (POLLHUP | POLLERR | POLLNVAL)))
+        {
+            // Такой fd готов всегда: progress уже дочитал, что было,
+            // дальше операция ждала бы вечно, а poll возвращался бы сразу
+            op->failed = true;
+            complete = true;
+        }
+        if (!complete && op->has_deadline && (int32_t)(now - op->deadline) >= 0)
+        {
+            op->timed_out = true;
+            complete = true;
+        }
+
+        if (!complete)
+            m_ops.push_back(op);
+        else if (op->handle)
+            op->handle.resume();
+    }
+    m_scan.clear();
+
+    // Снятые с наблюдения или завершенные и уже выбывшие из m_ops
+    for (size_t i = 0; i < m_watches.size();)
+    {
+        WatchOp *w = m_watches[i].get();
+        if ((!w->stream || w->failed || WatchOp::closed(w)) && std::find(m_ops.begin(), m_ops.end(), w) == m_ops.end())
+            m_watches.erase(m_watches.begin() + i);
+        else
+            i++;
+    }
+    return true;
+}
+
+#endif // __cpp_impl_coroutine
@@ -0,0 +1,273 @@
+#include "buffered.hpp"
+
+BufferedReader::BufferedReader(uStream &inner, size_t capacity)
+    : m_inner(inner), m_buf(capacity ? capacity : 1), m_head(0), m_tail(0) {}
+
+bool BufferedReader::open(const char *port, unsigned long baudrate)
+{
+    m_head = m_tail = 0;
+    return m_inner.open(port, baudrate);
+}
+
+void BufferedReader::close()
+{
+    m_inner.close();
+    m_head = m_tail = 0;
+}
+
+int BufferedReader::available() const
+{
+    return (int)(m_tail - m_head) + m_inner.available();
+}
+
+size_t BufferedReader::read(uint8_t *buffer, size_t length)
+{
+    if (!buffer || length == 0)
+        return 0;
+
+    if (m_head == m_tail)
+    {
+        // Крупные чтения идут мимо буфера, без лишнего копирования
+        if (length >= m_buf.size())
+            return m_inner.read(buffer, length);
+        if (fill() == 0)
+            return 0;
+    }
+
+    size_t n = std::min(length, m_tail - m_head);
+    memcpy(buffer, m_buf.data() + m_head, n);
+    m_head += n;
+    return n;
+}
+
+bool BufferedReader::poll(int timeout_ms)
+{
+    return m_head < m_tail || m_inner.poll(timeout_ms);
+}
+
+size_t BufferedReader::fill()
+{
+    if (m_head == m_tail)
+    {
+        m_head = m_tail = 0;
+    }
+    else if (m_head > 0 && m_tail == m_buf.size())
+    {
+        memmove(m_buf.data(), m_buf.data() + m_head, m_tail - m_head);
+        m_tail -= m_head;
+        m_head = 0;
+    }
+
+    size_t space = m_buf.size() - m_tail;
+    if (space == 0)
+        return 0;
+
+    int bytes_available = m_inner.available();
+    if (bytes_available <= 0)
+        return 0;
+
+    size_t n = m_inner.read(m_buf.data() + m_tail, std::min(space, (size_t)bytes_available));
+    if (n == (size_t)-1)
+        return 0;
+    m_tail += n;
+    return n;
+}
+
+sbu_t BufferedReader::peek(size_t n)
+{
+    if (n == 0 || n > m_buf.size())
+        return makeView(nullptr, 0);
+
+    if (m_buf.size() - m_head < n)
+    {
+        memmove(m_buf.data(), m_buf.data() + m_head, m_tail - m_head);
+        m_tail -= m_head;
+        m_head = 0;
+    }
+
+    while (m_tail - m_head < n)
+    {
+        if (fill() == 0)
+            return makeView(nullptr, 0);
+    }
+    return makeView(m_buf.data() + m_head, m_tail - m_head);
+}
+
+sbu_t BufferedReader::readUntil(uint8_t delim, uint32_t timeout_ms)
+{
+    uint32_t start_time = millis();
+    size_t scanned = 0;
+
+    while (true)
+    {
+        uint8_t *base = m_buf.data() + m_head;
+        size_t buffered_len = m_tail - m_head;
+
+        // Повторно просматриваем только новые байты
+        const uint8_t *hit = static_cast<const uint8_t *>(
+            memchr(base + scanned, delim, buffered_len - scanned));
+        if (hit)
+        {
+            size_t len = (size_t)(hit - base);
+            m_head += len + 1;
+            return makeView(base, len);
+        }
+        scanned = buffered_len;
+
+        if (buffered_len == m_buf.size())
+        {
+            m_head = m_tail;
+            return makeView(base, buffered_len);
+        }
+
+        // fill() может сдвинуть данные к началу, scanned считается от m_head
+        if (fill() > 0)
+            continue;
+
+        uint32_t elapsed = millis() - start_time;
+        if (elapsed >= timeout_ms || !m_inner.poll((int)(timeout_ms - elapsed)))
+            return makeView(nullptr, 0);
+    }
+}
+
+sbu_t BufferedReader::readLine(uint32_t timeout_ms)
+{
+    sbu_t line = readUntil('\n', timeout_ms);
+    if (line.ptr && line.end > line.ptr && line.end[-1] == '\r')
+        line.end--;
+    return line;
+}
+
+BufferedWriter::BufferedWriter(uStream &inner, size_t capacity,
+                               size_t flush_threshold, uint32_t flush_interval_ms)
+    : m_inner(inner), m_buf(capacity ? capacity : 1), m_len(0),
+      m_flush_threshold(flush_threshold), m_flush_interval_ms(flush_interval_ms), m_first_ms(0) {}
+
+BufferedWriter::~BufferedWriter()
+{
+    flushBuffer();
+}
+
+bool BufferedWriter::open(const char *port, unsigned long baudrate)
+{
+    m_len = 0;
+    return m_inner.open(port, baudrate);
+}
+
+void BufferedWriter::close()
+{
+    flushBuffer();
+    m_inner.close();
+}
+
+size_t BufferedWriter::write(const uint8_t *buffer, size_t length)
+{
+    if (!buffer || length == 0)
+        return 0;
+
+    struct iovec iov;
+    iov.iov_base = const_cast<uint8_t *>(buffer);
+    iov.iov_len = length;
+    return writev(&iov, 1);
+}
+
+size_t BufferedWriter::writev(const struct iovec *iov, int iovcnt)
+{
+    if (!iov || iovcnt <= 0)
+        return 0;
+
+    size_t total = 0;
+    for (int i = 0; i < iovcnt; i++)
+        total += iov[i].iov_len;
+    if (total == 0)
+        return 0;
+
+    if (m_len + total <= m_buf.size())
+    {
+        if (m_len == 0)
+            m_first_ms = millis();
+        for (int i = 0; i < iovcnt; i++)
+        {
+            memcpy(m_buf.data() + m_len, iov[i].iov_base, iov[i].iov_len);
+            m_len += iov[i].iov_len;
+        }
+        autoFlush();
+        return total;
+    }
+
+    // Не влезает: накопленное и новые данные уходят одним writev
+    static const int MAX_SEGMENTS = 16;
+    if (iovcnt >= MAX_SEGMENTS)
+    {
+        if (!flushBuffer())
+            return 0;
+        return m_inner.writev(iov, iovcnt);
+    }
+
+    struct iovec out[MAX_SEGMENTS];
+    out[0].iov_base = m_buf.data();
+    out[0].iov_len = m_len;
+    memcpy(out + 1, iov, (size_t)iovcnt * sizeof(struct iovec));
+
+    size_t sent = m_inner.writev(out, iovcnt + 1);
+    if (sent < m_len)
+    {
+        memmove(m_buf.data(), m_buf.data() + sent, m_len - sent);
+        m_len -= sent;
+        return 0;
+    }
+    sent -= m_len;
+    m_len = 0;
+    return sent;
+}
+
+bool BufferedWriter::flushBuffer()
+{
+    if (m_len == 0)
+        return true;
+
+    size_t sent = m_inner.write(m_buf.data(), m_len);
+    if (sent == 0 || sent == (size_t)-1)
+        return false;
+
+    if (sent < m_len)
+        memmove(m_buf.data(), m_buf.data() + sent, m_len - sent);
+    m_len -= std::min(sent, m_len);
+    m_first_ms = millis();
+    return m_len == 0;
+}
+
+void BufferedWriter::flush()
+{
+    flushBuffer();
+    m_inner.flush();
+}
+
+bool BufferedWriter::poll(int timeout_ms)
+{
+    autoFlush();
+    return m_inner.poll(timeout_ms);
+}
+
+sbu_t BufferedWriter::acquireWrite(size_t min)
+{
+    if (m_buf.size() - m_len < min)
+    {
+        flushBuffer();
+        if (m_buf.size() - m_len < min)
+            m_buf.resize(m_len + min);
+    }
+    return makeView(m_buf.data() + m_len, m_buf.size() - m_len);
+}
+
+size_t BufferedWriter::commitWrite(size_t n)
+{
+    n = std::min(n, m_buf.size() - m_len);
+    if (n == 0)
+        return 0;
+    if (m_len == 0)
+        m_first_ms = millis();
+    m_len += n;
+    autoFlush();
+    return n;
+}
@@ -0,0 +1,121 @@
+#include "chain.hpp"
+
+static const size_t CHAIN_CHUNK = 512;
+
+uint8_t *uChain::allocate(size_t n)
+{
+    if (UCHAIN_INLINE - m_used >= n)
+    {
+        uint8_t *p = m_inline + m_used;
+        m_used += n;
+        return p;
+    }
+    if (m_chunks.empty() || m_chunk_size - m_chunk_used < n)
+    {
+        m_chunk_size = std::max(n, CHAIN_CHUNK);
+        m_chunks.emplace_back(new uint8_t[m_chunk_size]);
+        m_chunk_used = 0;
+    }
+    uint8_t *p = m_chunks.back().get() + m_chunk_used;
+    m_chunk_used += n;
+    return p;
+}
+
+void uChain::append(const uint8_t *ptr, size_t len, bool owned)
+{
+    m_size += len;
+    // Своя память выделяется подряд: продолжение последнего сегмента
+    if (owned && !m_iov.empty())
+    {
+        struct iovec &last = m_iov.back();
+        if (static_cast<uint8_t *>(last.iov_base) + last.iov_len == ptr)
+        {
+            last.iov_len += len;
+            return;
+        }
+    }
+    struct iovec v;
+    v.iov_base = const_cast<uint8_t *>(ptr);
+    v.iov_len = len;
+    m_iov.push_back(v);
+}
+
+sbu_t uChain::reserve(size_t n)
+{
+    sbu_t window = {nullptr, nullptr};
+    if (n == 0)
+        return window;
+    uint8_t *p = allocate(n);
+    append(p, n, true);
+    sbu_init(&window, p, p + n);
+    return window;
+}
+
+void uChain::copy(const void *data, size_t len)
+{
+    if (!data || len == 0)
+        return;
+    sbu_t window = reserve(len);
+    memcpy(window.ptr, data, len);
+}
+
+void uChain::ref(const void *data, size_t len)
+{
+    if (!data || len == 0)
+        return;
+    append(static_cast<const uint8_t *>(data), len, false);
+}
+
+void uChain::clear()
+{
+    m_iov.clear();
+    m_chunks.clear();
+    m_used = m_size = 0;
+    m_chunk_used = m_chunk_size = 0;
+}
+
+uint8_t uChain::crc8(const crc8_ctx_t *ctx, uint8_t crc) const
+{
+    for (const struct iovec &v : m_iov)
+        crc = crc8_update(ctx, crc, v.iov_base, v.iov_len);
+    return crc;
+}
+
+uint16_t uChain::crc16(const crc16_ctx_t *ctx, uint16_t crc) const
+{
+    for (const struct iovec &v : m_iov)
+        crc = crc16_update(ctx, crc, v.iov_base, v.iov_len);
+    return crc;
+}
+
+size_t uChain::copyTo(uint8_t *dst, size_t capacity) const
+{
+    size_t total = 0;
+    for (const struct iovec &v : m_iov)
+    {
+        size_t n = std::min(v.iov_len, capacity - total);
+        memcpy(dst + total, v.iov_base, n);
+        total += n;
+        if (total == capacity)
+            break;
+    }
+    return total;
+}
+
+size_t uChain::writeTo(uStream &stream) const
+{
+    size_t total = 0;
+    size_t count = m_iov.size();
+    for (size_t i = 0; i < count; i += UCHAIN_IOV_MAX)
+    {
+        int n = (int)std::min(count - i, (size_t)UCHAIN_IOV_MAX);
+        size_t expected = 0;
+        for (int k = 0; k < n; k++)
+            expected += m_iov[i + k].iov_len;
+        size_t written = stream.writev(&m_iov[i], n);
+        total += written;
+        if (written != expected)
+            break;
+    }
+    return total;
+}
@@ -0,0 +1,59 @@
+#include "common.h"
+
+#if !defined(ARDUINO) && !defined(FURI_OS)
+#if UCLOCK_HAS_TSC
+#include <cpuid.h>
+#endif
+
+bool uClock::useTsc(uint32_t calibrate_ms)
+{
+#if UCLOCK_HAS_TSC
+    // CPUID 0x80000007, EDX бит 8: частота TSC не зависит от P/C-состояний
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) || !(edx & (1u << 8)))
+    {
+        LOG_WARN("Invariant TSC not available, staying on clock_gettime");
+        return false;
+    }
+
+    // Пары (нс, такты) снимаются вплотную, чтобы вытеснение не попало между ними
+    uint64_t ns0 = monotonicNs();
+    uint64_t tsc0 = __rdtsc();
+    struct timespec pause;
+    pause.tv_sec = calibrate_ms / 1000;
+    pause.tv_nsec = (long)(calibrate_ms % 1000) * 1000000L;
+    nanosleep(&pause, nullptr);
+    uint64_t ns1 = monotonicNs();
+    uint64_t tsc1 = __rdtsc();
+
+    if (tsc1 <= tsc0 || ns1 <= ns0)
+    {
+        LOG_WARN("TSC calibration failed, staying on clock_gettime");
+        return false;
+    }
+
+    uint64_t mult = (uint64_t)(((unsigned __int128)(ns1 - ns0) << 32) / (tsc1 - tsc0));
+
+    // Захват seqlock переводом счетчика в нечетное: параллельный useTsc()
+    // ждет, читатели повторяют чтение, пока запись не закончится
+    uint32_t seq = s_tsc_seq.load(std::memory_order_relaxed);
+    while ((seq & 1U) || !s_tsc_seq.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire,
+                                                          std::memory_order_relaxed))
+        seq = s_tsc_seq.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    s_tsc_mult.store(mult, std::memory_order_relaxed);
+    s_tsc_base.store(tsc1, std::memory_order_relaxed);
+    s_tsc_base_ns.store(ns1, std::memory_order_relaxed);
+    s_tsc_seq.store(seq + 2, std::memory_order_release);
+    s_tsc.store(true, std::memory_order_release);
+
+    LOG_INFO_F("TSC calibrated: %.3f MHz",
+               (double)(tsc1 - tsc0) * 1000.0 / (double)(ns1 - ns0));
+    return true;
+#else
+    (void)calibrate_ms;
+    return false;
+#endif
+}
+
+#endif // !ARDUINO && !FURI_OS
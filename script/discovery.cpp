@@ -0,0 +1,329 @@
+#if !defined(ARDUINO) && !defined(FURI_OS)
+#include "discovery.hpp"
+
+#include <ctype.h>
+#include <errno.h>
+#include <dirent.h>
+#include <limits.h>
+#include <stdio.h>
+#include <strings.h>
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#endif
+
+#define SYSFS_TTY "/sys/class/tty"
+#define DEV_SERIAL_BY_ID "/dev/serial/by-id"
+
+std::mutex uSerialDiscovery::s_mutex;
+std::vector<uSerialPortInfo> uSerialDiscovery::s_ports;
+bool uSerialDiscovery::s_valid = false;
+int uSerialDiscovery::s_uevent_fd = -1;
+struct timespec uSerialDiscovery::s_dev_mtime = {0, 0};
+
+static bool read_line(const std::string &path, std::string &out)
+{
+    FILE *f = fopen(path.c_str(), "r");
+    if (!f)
+        return false;
+
+    char buf[256];
+    bool ok = fgets(buf, sizeof(buf), f) != nullptr;
+    fclose(f);
+    if (!ok)
+        return false;
+
+    size_t len = strcspn(buf, "\r\n");
+    out.assign(buf, len);
+    return true;
+}
+
+static uint16_t read_hex(const std::string &path)
+{
+    std::string value;
+    if (!read_line(path, value))
+        return 0;
+    return (uint16_t)strtoul(value.c_str(), nullptr, 16);
+}
+
+static std::string link_basename(const std::string &path)
+{
+    char target[PATH_MAX];
+    ssize_t len = readlink(path.c_str(), target, sizeof(target) - 1);
+    if (len <= 0)
+        return std::string();
+    target[len] = '\0';
+    const char *name = strrchr(target, '/');
+    return name ? name + 1 : target;
+}
+
+// Сравнение с числами по значению: ttyUSB2 раньше ttyUSB10
+static bool natural_less(const std::string &a, const std::string &b)
+{
+    size_t i = 0, j = 0;
+    while (i < a.size() && j < b.size())
+    {
+        if (isdigit((unsigned char)a[i]) && isdigit((unsigned char)b[j]))
+        {
+            // Ведущие нули не влияют на значение, длиннее - значит больше
+            while (i < a.size() && a[i] == '0')
+                i++;
+            while (j < b.size() && b[j] == '0')
+                j++;
+            size_t i_end = i, j_end = j;
+            while (i_end < a.size() && isdigit((unsigned char)a[i_end]))
+                i_end++;
+            while (j_end < b.size() && isdigit((unsigned char)b[j_end]))
+                j_end++;
+            if (i_end - i != j_end - j)
+                return i_end - i < j_end - j;
+            int cmp = a.compare(i, i_end - i, b, j, j_end - j);
+            if (cmp != 0)
+                return cmp < 0;
+            i = i_end;
+            j = j_end;
+        }
+        else
+        {
+            if (a[i] != b[j])
+                return (unsigned char)a[i] < (unsigned char)b[j];
+            i++;
+            j++;
+        }
+    }
+    return a.size() - i < b.size() - j;
+}
+
+bool uSerialDiscovery::changed()
+{
+#ifdef __linux__
+    if (s_uevent_fd < 0)
+    {
+        s_uevent_fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                             NETLINK_KOBJECT_UEVENT);
+        if (s_uevent_fd >= 0)
+        {
+            struct sockaddr_nl addr;
+            memset(&addr, 0, sizeof(addr));
+            addr.nl_family = AF_NETLINK;
+            // Событие udev (группа 2) приходит, когда /dev/tty* и ссылки
+            // /dev/serial/by-id уже созданы; событие ядра (группа 1) их
+            // опережает. Без udev узлы создает devtmpfs еще до события ядра
+            addr.nl_groups = access("/run/udev/control", F_OK) == 0 ? 2 : 1;
+            if (bind(s_uevent_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+            {
+                LOG_WARN_F("uevent socket unavailable: %s", strerror(errno));
+                ::close(s_uevent_fd);
+                s_uevent_fd = -2;
+            }
+        }
+    }
+
+    if (s_uevent_fd >= 0)
+    {
+        // Нас интересуют только tty: вычитываем очередь и ищем SUBSYSTEM=tty
+        bool dirty = false;
+        char buf[4096];
+        ssize_t len;
+        while ((len = recv(s_uevent_fd, buf, sizeof(buf) - 1, 0)) > 0)
+        {
+            buf[len] = '\0';
+            for (ssize_t i = 0; i < len; i += (ssize_t)strlen(buf + i) + 1)
+            {
+                if (strcmp(buf + i, "SUBSYSTEM=tty") == 0)
+                    dirty = true;
+            }
+        }
+        // Сокет получает все uevent системы и вычитывается только из ports():
+        // при переполнении ядро отбрасывает события (ENOBUFS), и среди них
+        // могли быть tty. Любая ошибка, кроме пустой очереди, - пересканировать
+        if (len < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+            if (errno == ENOBUFS)
+                LOG_DEBUG("uevent queue overflowed, rescanning ports");
+            dirty = true;
+        }
+        return dirty;
+    }
+
+    // Без uevent ориентируемся на mtime /dev: меняется при создании/удалении узлов
+    struct stat st;
+    if (stat("/dev", &st) != 0)
+        return true;
+    bool dirty = st.st_mtim.tv_sec != s_dev_mtime.tv_sec ||
+                 st.st_mtim.tv_nsec != s_dev_mtime.tv_nsec;
+    s_dev_mtime = st.st_mtim;
+    return dirty;
+#else
+    // sysfs есть только в Linux, список всегда пуст
+    return false;
+#endif
+}
+
+bool uSerialDiscovery::readPortInfo(const std::string &name, uSerialPortInfo &info)
+{
+    std::string base = SYSFS_TTY "/" + name + "/device";
+
+    // Виртуальные консоли и pty не имеют device
+    char device_path[PATH_MAX];
+    if (!realpath(base.c_str(), device_path))
+        return false;
+
+    info.name = name;
+    info.device = "/dev/" + name;
+    info.driver = link_basename(base + "/driver");
+
+    // Неинициализированные заглушки 8250 есть в любой системе
+    if (info.driver == "serial8250")
+        return false;
+
+    // Поднимаемся от интерфейса к USB-устройству (там лежит idVendor)
+    std::string dir = device_path;
+    while (dir.size() > 1)
+    {
+        struct stat st;
+        if (stat((dir + "/idVendor").c_str(), &st) == 0)
+        {
+            info.vid = read_hex(dir + "/idVendor");
+            info.pid = read_hex(dir + "/idProduct");
+            read_line(dir + "/serial", info.serial);
+            read_line(dir + "/manufacturer", info.manufacturer);
+            read_line(dir + "/product", info.product);
+            break;
+        }
+        size_t slash = dir.rfind('/');
+        if (slash == std::string::npos || slash == 0)
+            break;
+        dir.resize(slash);
+    }
+    return true;
+}
+
+void uSerialDiscovery::scan(std::vector<uSerialPortInfo> &ports)
+{
+    ports.clear();
+
+    DIR *dir = opendir(SYSFS_TTY);
+    if (!dir)
+        return;
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != nullptr)
+    {
+        if (entry->d_name[0] == '.')
+            continue;
+        uSerialPortInfo info;
+        if (readPortInfo(entry->d_name, info))
+            ports.push_back(info);
+    }
+    closedir(dir);
+
+    DIR *by_id = opendir(DEV_SERIAL_BY_ID);
+    if (by_id)
+    {
+        while ((entry = readdir(by_id)) != nullptr)
+        {
+            if (entry->d_name[0] == '.')
+                continue;
+            std::string link = std::string(DEV_SERIAL_BY_ID "/") + entry->d_name;
+            std::string target = link_basename(link);
+            for (auto &port : ports)
+            {
+                if (port.name == target)
+                    port.by_id = link;
+            }
+        }
+        closedir(by_id);
+    }
+
+    std::sort(ports.begin(), ports.end(),
+              [](const uSerialPortInfo &a, const uSerialPortInfo &b)
+              { return natural_less(a.name, b.name); });
+
+    LOG_DEBUG_F("Serial discovery: %zu ports", ports.size());
+}
+
+std::vector<uSerialPortInfo> uSerialDiscovery::ports(bool refresh)
+{
+    std::lock_guard<std::mutex> lock(s_mutex);
+    // changed() вызываем всегда, чтобы вычитывать очередь uevent
+    if (changed() || refresh || !s_valid)
+    {
+        scan(s_ports);
+        s_valid = true;
+    }
+    return s_ports;
+}
+
+bool uSerialDiscovery::matches(const uSerialPortInfo &info, const char *id)
+{
+    if (info.device == id || info.name == id || info.by_id == id)
+        return true;
+
+    const char *by_id_name = strrchr(info.by_id.c_str(), '/');
+    if (by_id_name && strcmp(by_id_name + 1, id) == 0)
+        return true;
+
+    if (info.vid != 0)
+    {
+        unsigned vid = 0, pid = 0;
+        char serial[128] = {0};
+        int fields = sscanf(id, "%4x:%4x:%127s", &vid, &pid, serial);
+        if (fields >= 2 && vid == info.vid && pid == info.pid)
+            return fields == 2 || info.serial == serial;
+    }
+
+    return !info.serial.empty() && info.serial == id;
+}
+
+bool uSerialDiscovery::find(const char *id, uSerialPortInfo &info)
+{
+    if (!id || !*id)
+        return false;
+
+    // Путь (в том числе ссылка из by-id) открывается как есть, без
+    // сканирования: сведения об устройстве берем из кеша, если он уже есть
+    if (id[0] == '/')
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        for (const auto &port : s_ports)
+        {
+            if (port.device == id || port.by_id == id)
+            {
+                info = port;
+                return true;
+            }
+        }
+        info = uSerialPortInfo();
+        info.device = id;
+        return true;
+    }
+
+    for (int attempt = 0; attempt < 2; attempt++)
+    {
+        // Повторный проход с принудительным сканированием на случай,
+        // если uevent еще не дошел
+        for (const auto &port : ports(attempt > 0))
+        {
+            if (matches(port, id))
+            {
+                info = port;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool uSerialDiscovery::open(uSerial &port, const char *id, unsigned long baudrate)
+{
+    uSerialPortInfo info;
+    if (!find(id, info))
+    {
+        LOG_ERROR_F("Serial port '%s' not found", id ? id : "<null>");
+        return false;
+    }
+    return port.open(info.device.c_str(), baudrate);
+}
+#endif // !ARDUINO && !FURI_OS
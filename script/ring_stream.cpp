@@ -0,0 +1,666 @@
+#if !defined(ARDUINO) && !defined(FURI_OS)
+#include "ring_stream.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#endif
+
+static size_t page_size()
+{
+    long page = sysconf(_SC_PAGESIZE);
+    return page > 0 ? (size_t)page : 4096;
+}
+
+static size_t ring_capacity(size_t capacity)
+{
+    size_t page = page_size();
+    size_t cap = page;
+    while (cap < capacity)
+        cap <<= 1;
+    return cap;
+}
+
+// Слово futex лежит в общей памяти, поэтому без FUTEX_PRIVATE_FLAG
+static void futex_wait(std::atomic<uint32_t> *word, uint32_t expected, int64_t timeout_ns)
+{
+#ifdef __linux__
+    struct timespec ts;
+    struct timespec *pts = nullptr;
+    if (timeout_ns >= 0)
+    {
+        ts.tv_sec = (time_t)(timeout_ns / 1000000000LL);
+        ts.tv_nsec = (long)(timeout_ns % 1000000000LL);
+        pts = &ts;
+    }
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAIT, expected, pts, nullptr, 0);
+#else
+    (void)word;
+    (void)expected;
+    usleep(timeout_ns >= 0 && timeout_ns < 1000000 ? (useconds_t)(timeout_ns / 1000) : 1000);
+#endif
+}
+
+static void futex_wake(std::atomic<uint32_t> *word)
+{
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#else
+    (void)word;
+#endif
+}
+
+static void event_kick(int fd)
+{
+#ifdef __linux__
+    if (fd < 0)
+        return;
+    uint64_t one = 1;
+    ssize_t ret = ::write(fd, &one, sizeof(one));
+    (void)ret;
+#else
+    (void)fd;
+#endif
+}
+
+RingStream::RingStream()
+    : m_header(nullptr), m_map_size(0), m_rx(nullptr), m_tx(nullptr),
+      m_rx_data(nullptr), m_tx_data(nullptr), m_mask(0),
+      m_event_fd(-1), m_peer_event_fd(-1), m_write_timeout_ms(-1) {}
+
+RingStream::~RingStream()
+{
+    RingStream::close();
+}
+
+bool RingStream::format(int fd, size_t capacity)
+{
+    size_t page = page_size();
+    size_t cap = ring_capacity(capacity);
+    if (cap > UINT32_MAX || ftruncate(fd, (off_t)(page + 2 * cap)) != 0)
+    {
+        LOG_ERROR_F("Failed to size ring region: %s", strerror(errno));
+        return false;
+    }
+
+    void *mem = mmap(nullptr, page, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mem == MAP_FAILED)
+    {
+        LOG_ERROR_F("Failed to map ring header: %s", strerror(errno));
+        return false;
+    }
+
+    // Страница уже нулевая: кольца пусты, ожидающих нет
+    uRingHeader *header = static_cast<uRingHeader *>(mem);
+    memcpy(header->magic, URING_MAGIC, sizeof(header->magic));
+    header->version = URING_VERSION;
+    header->capacity = (uint32_t)cap;
+    header->ready.store(1, std::memory_order_release);
+    munmap(mem, page);
+    return true;
+}
+
+bool RingStream::attach(int fd, int side)
+{
+    size_t page = page_size();
+    void *probe = mmap(nullptr, page, PROT_READ, MAP_SHARED, fd, 0);
+    if (probe == MAP_FAILED)
+    {
+        LOG_ERROR_F("Failed to map ring header: %s", strerror(errno));
+        return false;
+    }
+    const uRingHeader *h = static_cast<const uRingHeader *>(probe);
+    bool valid = memcmp(h->magic, URING_MAGIC, sizeof(h->magic)) == 0 &&
+                 h->version == URING_VERSION &&
+                 h->ready.load(std::memory_order_acquire) == 1;
+    size_t cap = h->capacity;
+    munmap(probe, page);
+    if (!valid || cap < page || (cap & (cap - 1)) != 0)
+    {
+        LOG_ERROR("Not a ring stream region");
+        return false;
+    }
+
+    // Резервируем адреса, затем накладываем: заголовок и каждое кольцо дважды
+    size_t size = page + 4 * cap;
+    uint8_t *base = static_cast<uint8_t *>(
+        mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0));
+    if (base == MAP_FAILED)
+    {
+        LOG_ERROR_F("Failed to reserve %zu bytes for ring: %s", size, strerror(errno));
+        return false;
+    }
+
+    bool ok = mmap(base, page, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED;
+    for (int i = 0; ok && i < 4; i++)
+    {
+        off_t offset = (off_t)(page + (size_t)(i / 2) * cap);
+        ok = mmap(base + page + (size_t)i * cap, cap, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_FIXED, fd, offset) != MAP_FAILED;
+    }
+    if (!ok)
+    {
+        LOG_ERROR_F("Failed to map ring: %s", strerror(errno));
+        munmap(base, size);
+        return false;
+    }
+
+    uRingHeader *header = reinterpret_cast<uRingHeader *>(base);
+    if (side == 1 && header->attached.exchange(1, std::memory_order_acq_rel) != 0)
+    {
+        LOG_ERROR("Ring stream already has a peer");
+        munmap(base, size);
+        return false;
+    }
+
+    header->pid[side].store((int32_t)getpid(), std::memory_order_release);
+    m_header = header;
+    m_map_size = size;
+    m_tx = &header->ring[side];
+    m_rx = &header->ring[1 - side];
+    m_tx_data = base + page + (size_t)side * 2 * cap;
+    m_rx_data = base + page + (size_t)(1 - side) * 2 * cap;
+    m_mask = cap - 1;
+    STREAM_STAT_OPEN();
+    return true;
+}
+
+void RingStream::close()
+{
+    if (!m_header)
+        return;
+
+    m_tx->writer_closed.store(1, std::memory_order_release);
+    m_rx->reader_closed.store(1, std::memory_order_release);
+    m_tx->data_seq.fetch_add(1, std::memory_order_release);
+    m_rx->space_seq.fetch_add(1, std::memory_order_release);
+    futex_wake(&m_tx->data_seq);
+    futex_wake(&m_rx->space_seq);
+    // Как и WebSocket, будим ожидающих на pollFd(), чтобы они увидели закрытие
+    event_kick(m_peer_event_fd);
+
+    munmap(m_header, m_map_size);
+    m_header = nullptr;
+    m_map_size = 0;
+    m_rx = m_tx = nullptr;
+    m_rx_data = m_tx_data = nullptr;
+    m_mask = 0;
+
+    if (m_event_fd >= 0)
+        ::close(m_event_fd);
+    if (m_peer_event_fd >= 0)
+        ::close(m_peer_event_fd);
+    m_event_fd = m_peer_event_fd = -1;
+}
+
+int RingStream::available() const
+{
+    if (!m_header)
+        return 0;
+    uint64_t head = m_rx->head.load(std::memory_order_acquire);
+    return (int)std::min<uint64_t>(head - m_rx->tail.load(std::memory_order_relaxed), INT_MAX);
+}
+
+bool RingStream::isOpen() const
+{
+    return m_header &&
+           !m_rx->writer_closed.load(std::memory_order_acquire) &&
+           !m_tx->reader_closed.load(std::memory_order_acquire);
+}
+
+void RingStream::publish(uint64_t head, size_t n)
+{
+    m_tx->head.store(head + n, std::memory_order_release);
+    // Пара к fetch_add(readers_waiting) в waitData: либо читатель увидит
+    // новый head, либо мы увидим его в ожидании
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_tx->readers_waiting.load(std::memory_order_relaxed))
+    {
+        m_tx->data_seq.fetch_add(1, std::memory_order_release);
+        futex_wake(&m_tx->data_seq);
+        STREAM_STAT_ADD(STREAM_STAT_SYSCALLS, 1);
+    }
+    // Кольцо было пусто - читатель мог сбросить eventfd
+    if (m_peer_event_fd >= 0 && m_tx->tail.load(std::memory_order_relaxed) == head)
+        event_kick(m_peer_event_fd);
+    STREAM_STAT_ADD(STREAM_STAT_OPS_OUT, 1);
+    STREAM_STAT_ADD(STREAM_STAT_BYTES_OUT, n);
+}
+
+void RingStream::consume(size_t n)
+{
+    if (n == 0)
+        return;
+    uint64_t tail = m_rx->tail.load(std::memory_order_relaxed) + n;
+    m_rx->tail.store(tail, std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_rx->writers_waiting.load(std::memory_order_relaxed))
+    {
+        m_rx->space_seq.fetch_add(1, std::memory_order_release);
+        futex_wake(&m_rx->space_seq);
+        STREAM_STAT_ADD(STREAM_STAT_SYSCALLS, 1);
+    }
+    if (m_event_fd >= 0 && m_rx->head.load(std::memory_order_relaxed) == tail)
+        clearEvent();
+    STREAM_STAT_DELIVERED(n);
+}
+
+void RingStream::clearEvent()
+{
+#ifdef __linux__
+    uint64_t value;
+    ssize_t ret = ::read(m_event_fd, &value, sizeof(value));
+    (void)ret;
+    // Писатель мог добавить данные, пока мы сбрасывали
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_rx->head.load(std::memory_order_acquire) != m_rx->tail.load(std::memory_order_relaxed))
+        event_kick(m_event_fd);
+#endif
+}
+
+bool RingStream::waitData(int timeout_ms)
+{
+    uint64_t deadline = timeout_ms > 0 ? uClock::realNs() + (uint64_t)timeout_ms * 1000000ULL : 0;
+    while (true)
+    {
+        if (m_rx->head.load(std::memory_order_acquire) != m_rx->tail.load(std::memory_order_relaxed))
+            return true;
+        if (m_rx->writer_closed.load(std::memory_order_acquire) || timeout_ms == 0)
+            return false;
+
+        int64_t wait_ns = URING_LIVENESS_MS * 1000000LL;
+        if (timeout_ms > 0)
+        {
+            uint64_t now = uClock::realNs();
+            if (now >= deadline)
+                return false;
+            wait_ns = std::min<int64_t>(wait_ns, (int64_t)(deadline - now));
+        }
+        if (!peerAlive())
+        {
+            LOG_WARN("Ring stream writer exited without closing");
+            m_rx->writer_closed.store(1, std::memory_order_release);
+            return false;
+        }
+
+        m_rx->readers_waiting.fetch_add(1, std::memory_order_seq_cst);
+        uint32_t seq = m_rx->data_seq.load(std::memory_order_acquire);
+        if (m_rx->head.load(std::memory_order_acquire) == m_rx->tail.load(std::memory_order_relaxed) &&
+            !m_rx->writer_closed.load(std::memory_order_acquire))
+        {
+            futex_wait(&m_rx->data_seq, seq, wait_ns);
+            STREAM_STAT_ADD(STREAM_STAT_SYSCALLS, 1);
+        }
+        m_rx->readers_waiting.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+bool RingStream::peerAlive() const
+{
+    int side = m_tx == &m_header->ring[0] ? 0 : 1;
+    pid_t pid = (pid_t)m_header->pid[1 - side].load(std::memory_order_acquire);
+    // Сторона еще не подключилась; в своем процессе канал не осиротеет
+    if (pid <= 0 || pid == getpid())
+        return true;
+    if (kill(pid, 0) != 0 && errno == ESRCH)
+        return false;
+#ifdef __linux__
+    // kill() успешен и для зомби: дочерний процесс, завершившийся без
+    // close(), остается им, пока родитель (часто - мы сами, ждущие здесь)
+    // не вызовет wait. Состояние в /proc/<pid>/stat - после последней ')'
+    char path[32];
+    snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+    FILE *f = fopen(path, "re");
+    if (!f)
+        return errno != ENOENT;
+    char stat[512];
+    size_t n = fread(stat, 1, sizeof(stat) - 1, f);
+    fclose(f);
+    stat[n] = '\0';
+    const char *state = strrchr(stat, ')');
+    if (state && state[1] == ' ' && (state[2] == 'Z' || state[2] == 'X'))
+        return false;
+#endif
+    return true;
+}
+
+bool RingStream::waitSpace(size_t n, int timeout_ms)
+{
+    uint64_t deadline = timeout_ms > 0 ? uClock::realNs() + (uint64_t)timeout_ms * 1000000ULL : 0;
+    while (true)
+    {
+        uint64_t used = m_tx->head.load(std::memory_order_relaxed) - m_tx->tail.load(std::memory_order_acquire);
+        if (capacity() - used >= n)
+            return true;
+        if (m_tx->reader_closed.load(std::memory_order_acquire) || timeout_ms == 0)
+            return false;
+
+        // Бесконечное ожидание режется на шаги: читатель мог умереть,
+        // не выставив reader_closed, и тогда место не освободится никогда
+        int64_t wait_ns = URING_LIVENESS_MS * 1000000LL;
+        if (timeout_ms > 0)
+        {
+            uint64_t now = uClock::realNs();
+            if (now >= deadline)
+                return false;
+            wait_ns = std::min<int64_t>(wait_ns, (int64_t)(deadline - now));
+        }
+        if (!peerAlive())
+        {
+            LOG_WARN("Ring stream reader exited without closing");
+            m_tx->reader_closed.store(1, std::memory_order_release);
+            return false;
+        }
+
+        m_tx->writers_waiting.fetch_add(1, std::memory_order_seq_cst);
+        uint32_t seq = m_tx->space_seq.load(std::memory_order_acquire);
+        used = m_tx->head.load(std::memory_order_relaxed) - m_tx->tail.load(std::memory_order_acquire);
+        if (capacity() - used < n && !m_tx->reader_closed.load(std::memory_order_acquire))
+        {
+            futex_wait(&m_tx->space_seq, seq, wait_ns);
+            STREAM_STAT_ADD(STREAM_STAT_SYSCALLS, 1);
+        }
+        m_tx->writers_waiting.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+bool RingStream::poll(int timeout_ms)
+{
+    if (!m_header)
+        return false;
+    STREAM_STAT_START(wait_started);
+    bool ready = waitData(timeout_ms);
+    if (timeout_ms != 0)
+        STREAM_STAT_WAIT_DONE(wait_started);
+    return ready;
+}
+
+uint8_t RingStream::read()
+{
+    uint8_t byte;
+    if (read(&byte, 1) == 1)
+        return byte;
+    return static_cast<uint8_t>(-1);
+}
+
+size_t RingStream::read(uint8_t *buffer, size_t length)
+{
+    if (!m_header || !buffer || length == 0)
+        return 0;
+
+    uint64_t tail = m_rx->tail.load(std::memory_order_relaxed);
+    size_t n = (size_t)std::min<uint64_t>(length, m_rx->head.load(std::memory_order_acquire) - tail);
+    if (n == 0)
+        return 0;
+    memcpy(buffer, m_rx_data + (tail & m_mask), n);
+    consume(n);
+    return n;
+}
+
+size_t RingStream::readv(const struct iovec *iov, int iovcnt)
+{
+    if (!m_header || !iov || iovcnt <= 0)
+        return 0;
+
+    uint64_t tail = m_rx->tail.load(std::memory_order_relaxed);
+    size_t left = (size_t)(m_rx->head.load(std::memory_order_acquire) - tail);
+    const uint8_t *src = m_rx_data + (tail & m_mask);
+    size_t total = 0;
+    for (int i = 0; i < iovcnt && left > 0; i++)
+    {
+        size_t n = std::min(iov[i].iov_len, left);
+        memcpy(iov[i].iov_base, src + total, n);
+        total += n;
+        left -= n;
+    }
+    consume(total);
+    return total;
+}
+
+size_t RingStream::write(uint8_t byte)
+{
+    struct iovec iov;
+    iov.iov_base = &byte;
+    iov.iov_len = 1;
+    return push(&iov, 1);
+}
+
+size_t RingStream::write(const uint8_t *buffer, size_t length)
+{
+    if (!buffer || length == 0)
+        return 0;
+    struct iovec iov;
+    iov.iov_base = const_cast<uint8_t *>(buffer);
+    iov.iov_len = length;
+    return push(&iov, 1);
+}
+
+size_t RingStream::writev(const struct iovec *iov, int iovcnt)
+{
+    if (!iov || iovcnt <= 0)
+        return 0;
+    return push(iov, iovcnt);
+}
+
+size_t RingStream::push(const struct iovec *iov, int iovcnt)
+{
+    if (!m_header)
+        return 0;
+
+    size_t total = 0;
+    for (int i = 0; i < iovcnt; i++)
+        total += iov[i].iov_len;
+
+    // Как блокирующий fd: ждем места, пока не запишем все или читатель не уйдет
+    size_t done = 0;
+    int seg = 0;
+    size_t seg_off = 0;
+    while (done < total)
+    {
+        if (!waitSpace(std::min(total - done, capacity() / 2), m_write_timeout_ms))
+            break;
+
+        uint64_t head = m_tx->head.load(std::memory_order_relaxed);
+        size_t space = capacity() - (size_t)(head - m_tx->tail.load(std::memory_order_acquire));
+        size_t chunk = std::min(space, total - done);
+        uint8_t *dst = m_tx_data + (head & m_mask);
+        for (size_t copied = 0; copied < chunk;)
+        {
+            size_t n = std::min(iov[seg].iov_len - seg_off, chunk - copied);
+            memcpy(dst + copied, static_cast<const uint8_t *>(iov[seg].iov_base) + seg_off, n);
+            copied += n;
+            seg_off += n;
+            if (seg_off == iov[seg].iov_len)
+            {
+                seg++;
+                seg_off = 0;
+            }
+        }
+        publish(head, chunk);
+        done += chunk;
+    }
+    return done;
+}
+
+sbu_t RingStream::acquireRead(size_t min)
+{
+    if (!m_header)
+        return makeView(nullptr, 0);
+    if (min == 0)
+        min = 1;
+
+    uint64_t tail = m_rx->tail.load(std::memory_order_relaxed);
+    size_t ready = (size_t)(m_rx->head.load(std::memory_order_acquire) - tail);
+    if (ready < min)
+        return makeView(nullptr, 0);
+    return makeView(m_rx_data + (tail & m_mask), ready);
+}
+
+void RingStream::releaseRead(size_t n)
+{
+    if (!m_header)
+        return;
+    size_t ready = (size_t)(m_rx->head.load(std::memory_order_acquire) -
+                            m_rx->tail.load(std::memory_order_relaxed));
+    consume(std::min(n, ready));
+}
+
+sbu_t RingStream::acquireWrite(size_t min)
+{
+    if (!m_header || min > capacity() || !waitSpace(min, m_write_timeout_ms))
+        return makeView(nullptr, 0);
+
+    uint64_t head = m_tx->head.load(std::memory_order_relaxed);
+    size_t space = capacity() - (size_t)(head - m_tx->tail.load(std::memory_order_acquire));
+    return makeView(m_tx_data + (head & m_mask), space);
+}
+
+size_t RingStream::commitWrite(size_t n)
+{
+    if (!m_header)
+        return 0;
+    uint64_t head = m_tx->head.load(std::memory_order_relaxed);
+    size_t space = capacity() - (size_t)(head - m_tx->tail.load(std::memory_order_acquire));
+    n = std::min(n, space);
+    if (n > 0)
+        publish(head, n);
+    return n;
+}
+
+static int anonymous_region()
+{
+#ifdef __linux__
+    return memfd_create("ustream-ring", MFD_CLOEXEC);
+#else
+    char name[64];
+    snprintf(name, sizeof(name), "/ustream-ring-%d-%p", (int)getpid(), (void *)&name);
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd >= 0)
+        shm_unlink(name);
+    return fd;
+#endif
+}
+
+bool MemoryStream::pair(MemoryStream &a, MemoryStream &b, size_t capacity)
+{
+    a.close();
+    b.close();
+
+    int fd = anonymous_region();
+    if (fd < 0)
+    {
+        LOG_ERROR_F("Failed to create ring region: %s", strerror(errno));
+        return false;
+    }
+
+    bool ok = format(fd, capacity) && a.attach(fd, 0) && b.attach(fd, 1);
+    ::close(fd);
+    if (!ok)
+    {
+        a.close();
+        b.close();
+        return false;
+    }
+
+#ifdef __linux__
+    a.m_event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    b.m_event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (a.m_event_fd >= 0 && b.m_event_fd >= 0)
+    {
+        a.m_peer_event_fd = fcntl(b.m_event_fd, F_DUPFD_CLOEXEC, 0);
+        b.m_peer_event_fd = fcntl(a.m_event_fd, F_DUPFD_CLOEXEC, 0);
+    }
+#endif
+    return true;
+}
+
+bool MemoryStream::open(const char *port, unsigned long baudrate)
+{
+    (void)port;
+    (void)baudrate;
+    LOG_ERROR("MemoryStream is opened with MemoryStream::pair()");
+    return false;
+}
+
+ShmStream::~ShmStream()
+{
+    close();
+}
+
+bool ShmStream::create(const char *name, size_t capacity, bool replace)
+{
+    close();
+    if (!name)
+        return false;
+
+    // Без replace чужой живой канал с тем же именем не трогаем
+    if (replace)
+        shm_unlink(name);
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (fd < 0)
+    {
+        int err = errno;
+        LOG_ERROR_F("Failed to create shared memory '%s': %s", name, strerror(err));
+        errno = err;
+        return false;
+    }
+
+    bool ok = format(fd, capacity) && attach(fd, 0);
+    ::close(fd);
+    if (!ok)
+    {
+        shm_unlink(name);
+        return false;
+    }
+
+    m_name = name;
+    m_owner = true;
+    LOG_INFO_F("ShmStream '%s' created, %zu bytes per direction", name, this->capacity());
+    return true;
+}
+
+bool ShmStream::open(const char *name, unsigned long baudrate)
+{
+    (void)baudrate;
+    close();
+    if (!name)
+        return false;
+
+    int fd = shm_open(name, O_RDWR | O_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        LOG_ERROR_F("Failed to open shared memory '%s': %s", name, strerror(errno));
+        return false;
+    }
+
+    bool ok = attach(fd, 1);
+    ::close(fd);
+    if (!ok)
+        return false;
+
+    m_name = name;
+    m_owner = false;
+    LOG_INFO_F("ShmStream '%s' attached", name);
+    return true;
+}
+
+void ShmStream::close()
+{
+    if (m_owner && !m_name.empty())
+        shm_unlink(m_name.c_str());
+    m_owner = false;
+    m_name.clear();
+    RingStream::close();
+}
+
+#endif // !ARDUINO && !FURI_OS
@@ -23,8 +23,24 @@
  * SOFTWARE.
  */
 
+// Внешние символы для совместимости; реализация общая с inline-версиями
+#ifndef SBU_NO_INLINE
+#define SBU_NO_INLINE
+#endif
 #include "sbu.h"
 
+#include <stdlib.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 sbu_t *sbu_init(sbu_t *sbu, uint8_t *ptr, uint8_t *end)
 {
     sbu->ptr = ptr;
@@ -92,40 +108,92 @@ bool sbu_write_data_safe(sbu_t *dst, const void *data, int len)
 
 void sbu_write_u8(sbu_t *dst, uint8_t val)
 {
-    *dst->ptr++ = val;
+    sbu_fast_write_u8(dst, val);
 }
 
 void sbu_write_i8(sbu_t *dst, int8_t val)
 {
-    *dst->ptr++ = (uint8_t)val;
+    sbu_fast_write_i8(dst, val);
 }
 
 void sbu_write_u16le(sbu_t *dst, uint16_t val)
 {
-    *dst->ptr++ = (uint8_t)(val >> 0);
-    *dst->ptr++ = (uint8_t)(val >> 8);
+    sbu_fast_write_u16le(dst, val);
 }
 
 void sbu_write_u16be(sbu_t *dst, uint16_t val)
 {
-    *dst->ptr++ = (uint8_t)(val >> 8);
-    *dst->ptr++ = (uint8_t)(val >> 0);
+    sbu_fast_write_u16be(dst, val);
+}
+
+void sbu_write_u24le(sbu_t *dst, uint32_t val)
+{
+    sbu_fast_write_u24le(dst, val);
+}
+
+void sbu_write_u24be(sbu_t *dst, uint32_t val)
+{
+    sbu_fast_write_u24be(dst, val);
 }
 
 void sbu_write_u32le(sbu_t *dst, uint32_t val)
 {
-    *dst->ptr++ = (uint8_t)(val >> 0);
-    *dst->ptr++ = (uint8_t)(val >> 8);
-    *dst->ptr++ = (uint8_t)(val >> 16);
-    *dst->ptr++ = (uint8_t)(val >> 24);
+    sbu_fast_write_u32le(dst, val);
 }
 
 void sbu_write_u32be(sbu_t *dst, uint32_t val)
 {
-    *dst->ptr++ = (uint8_t)(val >> 24);
-    *dst->ptr++ = (uint8_t)(val >> 16);
-    *dst->ptr++ = (uint8_t)(val >> 8);
-    *dst->ptr++ = (uint8_t)(val >> 0);
+    sbu_fast_write_u32be(dst, val);
+}
+
+void sbu_write_u64le(sbu_t *dst, uint64_t val)
+{
+    sbu_fast_write_u64le(dst, val);
+}
+
+void sbu_write_u64be(sbu_t *dst, uint64_t val)
+{
+    sbu_fast_write_u64be(dst, val);
+}
+
+void sbu_write_f32le(sbu_t *dst, float val)
+{
+    sbu_fast_write_f32le(dst, val);
+}
+
+void sbu_write_f32be(sbu_t *dst, float val)
+{
+    sbu_fast_write_f32be(dst, val);
+}
+
+void sbu_write_f64le(sbu_t *dst, double val)
+{
+    sbu_fast_write_f64le(dst, val);
+}
+
+void sbu_write_f64be(sbu_t *dst, double val)
+{
+    sbu_fast_write_f64be(dst, val);
+}
+
+void sbu_write_uvarint(sbu_t *dst, uint64_t val)
+{
+    sbu_fast_write_uvarint(dst, val);
+}
+
+void sbu_write_svarint(sbu_t *dst, int64_t val)
+{
+    sbu_fast_write_svarint(dst, val);
+}
+
+bool sbu_write_uvarint_safe(sbu_t *dst, uint64_t val)
+{
+    return sbu_fast_write_uvarint_safe(dst, val);
+}
+
+bool sbu_write_svarint_safe(sbu_t *dst, int64_t val)
+{
+    return sbu_fast_write_svarint_safe(dst, val);
 }
 
 void sbu_write_string(sbu_t *dst, const char *string)
@@ -155,64 +223,122 @@ void sbu_read_data(sbu_t *src, void *data, int len)
 
 uint8_t sbu_read_u8(sbu_t *src)
 {
-    return *src->ptr++;
+    return sbu_fast_read_u8(src);
 }
 
 int8_t sbu_read_i8(sbu_t *src)
 {
-    return (int8_t)(*src->ptr++);
+    return sbu_fast_read_i8(src);
 }
 
 uint16_t sbu_read_u16le(sbu_t *src)
 {
-    uint16_t b0 = (uint16_t)sbu_read_u8(src);
-    uint16_t b1 = (uint16_t)sbu_read_u8(src);
-    return (uint16_t)(b0 | (uint16_t)(b1 << 8));
+    return sbu_fast_read_u16le(src);
 }
 
 uint16_t sbu_read_u16be(sbu_t *src)
 {
-    uint16_t b0 = (uint16_t)sbu_read_u8(src);
-    uint16_t b1 = (uint16_t)sbu_read_u8(src);
-    return (uint16_t)((uint16_t)(b0 << 8) | b1);
+    return sbu_fast_read_u16be(src);
 }
 
 int16_t sbu_read_i16le(sbu_t *src)
 {
-    return (int16_t)sbu_read_u16le(src);
+    return sbu_fast_read_i16le(src);
 }
 
 int16_t sbu_read_i16be(sbu_t *src)
 {
-    return (int16_t)sbu_read_u16be(src);
+    return sbu_fast_read_i16be(src);
+}
+
+uint32_t sbu_read_u24le(sbu_t *src)
+{
+    return sbu_fast_read_u24le(src);
+}
+
+uint32_t sbu_read_u24be(sbu_t *src)
+{
+    return sbu_fast_read_u24be(src);
+}
+
+int32_t sbu_read_i24le(sbu_t *src)
+{
+    return sbu_fast_read_i24le(src);
+}
+
+int32_t sbu_read_i24be(sbu_t *src)
+{
+    return sbu_fast_read_i24be(src);
 }
 
 uint32_t sbu_read_u32le(sbu_t *src)
 {
-    uint32_t b0 = (uint32_t)sbu_read_u8(src);
-    uint32_t b1 = (uint32_t)sbu_read_u8(src);
-    uint32_t b2 = (uint32_t)sbu_read_u8(src);
-    uint32_t b3 = (uint32_t)sbu_read_u8(src);
-    return (uint32_t)(b0 | (b1 << 8) | (b2 << 16) | (b3 << 24));
+    return sbu_fast_read_u32le(src);
 }
 
 uint32_t sbu_read_u32be(sbu_t *src)
 {
-    uint32_t b0 = (uint32_t)sbu_read_u8(src);
-    uint32_t b1 = (uint32_t)sbu_read_u8(src);
-    uint32_t b2 = (uint32_t)sbu_read_u8(src);
-    uint32_t b3 = (uint32_t)sbu_read_u8(src);
-    return (uint32_t)((b0 << 24) | (b1 << 16) | (b2 << 8) | b3);
+    return sbu_fast_read_u32be(src);
 }
 
 int32_t sbu_read_i32le(sbu_t *src)
 {
-    return (int32_t)sbu_read_u32le(src);
+    return sbu_fast_read_i32le(src);
 }
 
 int32_t sbu_read_i32be(sbu_t *src)
 {
-    return (int32_t)sbu_read_u32be(src);
+    return sbu_fast_read_i32be(src);
+}
+
+uint64_t sbu_read_u64le(sbu_t *src)
+{
+    return sbu_fast_read_u64le(src);
+}
+
+uint64_t sbu_read_u64be(sbu_t *src)
+{
+    return sbu_fast_read_u64be(src);
+}
+
+int64_t sbu_read_i64le(sbu_t *src)
+{
+    return sbu_fast_read_i64le(src);
+}
+
+int64_t sbu_read_i64be(sbu_t *src)
+{
+    return sbu_fast_read_i64be(src);
+}
+
+float sbu_read_f32le(sbu_t *src)
+{
+    return sbu_fast_read_f32le(src);
+}
+
+float sbu_read_f32be(sbu_t *src)
+{
+    return sbu_fast_read_f32be(src);
+}
+
+double sbu_read_f64le(sbu_t *src)
+{
+    return sbu_fast_read_f64le(src);
+}
+
+double sbu_read_f64be(sbu_t *src)
+{
+    return sbu_fast_read_f64be(src);
+}
+
+uint64_t sbu_read_uvarint(sbu_t *src)
+{
+    return sbu_fast_read_uvarint(src);
+}
+
+int64_t sbu_read_svarint(sbu_t *src)
+{
+    return sbu_fast_read_svarint(src);
 }
 
 bool sbu_read_data_safe(sbu_t *src, void *data, int len)
@@ -332,3 +458,845 @@ bool sbu_read_i32be_safe(int32_t *val, sbu_t *src)
     }
     return true;
 }
+
+bool sbu_read_u24le_safe(uint32_t *val, sbu_t *src)
+{
+    return sbu_fast_read_u24le_safe(val, src);
+}
+
+bool sbu_read_i24le_safe(int32_t *val, sbu_t *src)
+{
+    return sbu_fast_read_i24le_safe(val, src);
+}
+
+bool sbu_read_u24be_safe(uint32_t *val, sbu_t *src)
+{
+    return sbu_fast_read_u24be_safe(val, src);
+}
+
+bool sbu_read_i24be_safe(int32_t *val, sbu_t *src)
+{
+    return sbu_fast_read_i24be_safe(val, src);
+}
+
+bool sbu_read_u64le_safe(uint64_t *val, sbu_t *src)
+{
+    return sbu_fast_read_u64le_safe(val, src);
+}
+
+bool sbu_read_i64le_safe(int64_t *val, sbu_t *src)
+{
+    return sbu_fast_read_i64le_safe(val, src);
+}
+
+bool sbu_read_u64be_safe(uint64_t *val, sbu_t *src)
+{
+    return sbu_fast_read_u64be_safe(val, src);
+}
+
+bool sbu_read_i64be_safe(int64_t *val, sbu_t *src)
+{
+    return sbu_fast_read_i64be_safe(val, src);
+}
+
+bool sbu_read_f32le_safe(float *val, sbu_t *src)
+{
+    return sbu_fast_read_f32le_safe(val, src);
+}
+
+bool sbu_read_f32be_safe(float *val, sbu_t *src)
+{
+    return sbu_fast_read_f32be_safe(val, src);
+}
+
+bool sbu_read_f64le_safe(double *val, sbu_t *src)
+{
+    return sbu_fast_read_f64le_safe(val, src);
+}
+
+bool sbu_read_f64be_safe(double *val, sbu_t *src)
+{
+    return sbu_fast_read_f64be_safe(val, src);
+}
+
+bool sbu_read_uvarint_safe(uint64_t *val, sbu_t *src)
+{
+    return sbu_fast_read_uvarint_safe(val, src);
+}
+
+bool sbu_read_svarint_safe(int64_t *val, sbu_t *src)
+{
+    return sbu_fast_read_svarint_safe(val, src);
+}
+
+// Пакетный разбор varint. Значение до 8 байт берется одной загрузкой u64:
+// конец ищется по старшим битам (ctz), 7-битные группы сжимаются тремя
+// масками и сдвигами - без цикла по байтам. Подряд идущие однобайтовые
+// значения (частый случай телеметрии) копируются блоками по 16 (SSE2)
+// или 8 байт. Длинные значения и хвост буфера - обычный разбор
+#define SBU_MSB64 0x8080808080808080ULL
+
+static int sbu_ctz64(uint64_t v)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(v);
+#else
+    int n = 0;
+    while (!(v & 1)) { v >>= 1; n++; }
+    return n;
+#endif
+}
+
+static uint64_t sbu_varint_compact(uint64_t x)
+{
+    x &= 0x7F7F7F7F7F7F7F7FULL;
+    x = ((x & 0x7F007F007F007F00ULL) >> 1) | (x & 0x007F007F007F007FULL);
+    x = ((x & 0x3FFF00003FFF0000ULL) >> 2) | (x & 0x00003FFF00003FFFULL);
+    x = ((x & 0x0FFFFFFF00000000ULL) >> 4) | (x & 0x000000000FFFFFFFULL);
+    return x;
+}
+
+int sbu_read_uvarint_batch(sbu_t *src, uint64_t *vals, int count)
+{
+    const uint8_t *p, *end;
+    int n = 0, i;
+    if (!src || !vals || count <= 0 || sbu_left(src) <= 0) return 0;
+    p = src->ptr;
+    end = src->end;
+
+    while (n < count)
+    {
+        size_t left = (size_t)(end - p);
+        uint64_t x, stop, v;
+        int len;
+#if defined(__SSE2__)
+        if (count - n >= 16 && left >= 16)
+        {
+            __m128i block = _mm_loadu_si128((const __m128i *)p);
+            if (_mm_movemask_epi8(block) == 0)
+            {
+                for (i = 0; i < 16; i++) vals[n + i] = p[i];
+                p += 16;
+                n += 16;
+                continue;
+            }
+        }
+#endif
+        if (left >= 8)
+        {
+            x = SBU_TO_LE64(sbu_load64(p));
+            if (count - n >= 8 && (x & SBU_MSB64) == 0)
+            {
+                for (i = 0; i < 8; i++) vals[n + i] = p[i];
+                p += 8;
+                n += 8;
+                continue;
+            }
+            stop = ~x & SBU_MSB64;
+            if (stop)
+            {
+                len = (sbu_ctz64(stop) >> 3) + 1;
+                // stop ^ (stop - 1): все биты до конечного байта включительно
+                vals[n++] = sbu_varint_compact(x & (stop ^ (stop - 1)));
+                p += len;
+                continue;
+            }
+        }
+        len = sbu_varint_decode(p, left, &v);
+        if (!len) break;
+        vals[n++] = v;
+        p += len;
+    }
+
+    src->ptr = (uint8_t *)p;
+    return n;
+}
+
+int sbu_read_svarint_batch(sbu_t *src, int64_t *vals, int count)
+{
+    // int64_t и uint64_t можно адресовать одним указателем
+    uint64_t *raw = (uint64_t *)vals;
+    int n = sbu_read_uvarint_batch(src, raw, count), i;
+    for (i = 0; i < n; i++) vals[i] = sbu_unzigzag64(raw[i]);
+    return n;
+}
+
+// Маска pshufb: в каждой 16-байтовой полосе развернуть слова по width байт
+#if defined(__SSSE3__) || defined(__AVX2__)
+static __m128i sbu_bswap_mask(int width)
+{
+    if (width == 2) return _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    if (width == 4) return _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    return _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+}
+#endif
+
+void sbu_bswap_copy(void *dst, const void *src, size_t bytes, int width)
+{
+    uint8_t *d = (uint8_t *)dst;
+    const uint8_t *s = (const uint8_t *)src;
+    size_t i = 0;
+
+#if defined(__SSSE3__) || defined(__AVX2__)
+    __m128i mask = sbu_bswap_mask(width);
+#if defined(__AVX2__)
+    __m256i mask2 = _mm256_broadcastsi128_si256(mask);
+    for (; i + 32 <= bytes; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(s + i));
+        _mm256_storeu_si256((__m256i *)(d + i), _mm256_shuffle_epi8(v, mask2));
+    }
+#endif
+    for (; i + 16 <= bytes; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+        _mm_storeu_si128((__m128i *)(d + i), _mm_shuffle_epi8(v, mask));
+    }
+#elif defined(__SSE2__)
+    // Без pshufb: слова переставляются shufflelo/hi, байты в 16-битных - сдвигами
+    for (; i + 16 <= bytes; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(s + i));
+        if (width == 4)
+        {
+            v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+            v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+        }
+        else if (width == 8)
+        {
+            v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+            v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(0, 1, 2, 3));
+        }
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        _mm_storeu_si128((__m128i *)(d + i), v);
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 16 <= bytes; i += 16)
+    {
+        uint8x16_t v = vld1q_u8(s + i);
+        v = width == 2 ? vrev16q_u8(v) : width == 4 ? vrev32q_u8(v) : vrev64q_u8(v);
+        vst1q_u8(d + i, v);
+    }
+#endif
+
+    if (width == 2)
+        for (; i < bytes; i += 2) sbu_store16(d + i, SBU_BSWAP16(sbu_load16(s + i)));
+    else if (width == 4)
+        for (; i < bytes; i += 4) sbu_store32(d + i, SBU_BSWAP32(sbu_load32(s + i)));
+    else
+        for (; i < bytes; i += 8) sbu_store64(d + i, SBU_BSWAP64(sbu_load64(s + i)));
+}
+
+// big - порядок байт на проводе; совпал с хостом - обычное копирование
+static void sbu_array_copy(uint8_t *dst, const uint8_t *src, size_t bytes, int width, int big)
+{
+    if (big == SBU_BIG_ENDIAN)
+        memcpy(dst, src, bytes);
+    else
+        sbu_bswap_copy(dst, src, bytes, width);
+}
+
+#define SBU_ARRAY_IMPL(name, type, big)                                                   \
+    void sbu_write_##name##_array(sbu_t *dst, const type *vals, int count)                \
+    {                                                                                     \
+        size_t bytes;                                                                     \
+        if (!dst || !vals || count <= 0) return;                                          \
+        bytes = (size_t)count * sizeof(type);                                             \
+        sbu_array_copy(dst->ptr, (const uint8_t *)vals, bytes, (int)sizeof(type), big);   \
+        dst->ptr += bytes;                                                                \
+    }                                                                                     \
+    bool sbu_write_##name##_array_safe(sbu_t *dst, const type *vals, int count)           \
+    {                                                                                     \
+        if (!dst || !vals || count <= 0) return false;                                    \
+        if ((size_t)sbu_left(dst) < (size_t)count * sizeof(type)) return false;           \
+        sbu_write_##name##_array(dst, vals, count);                                       \
+        return true;                                                                      \
+    }                                                                                     \
+    void sbu_read_##name##_array(sbu_t *src, type *vals, int count)                       \
+    {                                                                                     \
+        size_t bytes;                                                                     \
+        if (!src || count <= 0) return;                                                   \
+        bytes = (size_t)count * sizeof(type);                                             \
+        if (vals) sbu_array_copy((uint8_t *)vals, src->ptr, bytes, (int)sizeof(type), big); \
+        src->ptr += bytes;                                                                \
+    }                                                                                     \
+    bool sbu_read_##name##_array_safe(sbu_t *src, type *vals, int count)                  \
+    {                                                                                     \
+        if (!src || count <= 0) return false;                                             \
+        if ((size_t)sbu_left(src) < (size_t)count * sizeof(type)) return false;           \
+        sbu_read_##name##_array(src, vals, count);                                        \
+        return true;                                                                      \
+    }
+
+SBU_ARRAY_IMPL(u16le, uint16_t, 0)
+SBU_ARRAY_IMPL(u16be, uint16_t, 1)
+SBU_ARRAY_IMPL(i16le, int16_t, 0)
+SBU_ARRAY_IMPL(i16be, int16_t, 1)
+SBU_ARRAY_IMPL(u32le, uint32_t, 0)
+SBU_ARRAY_IMPL(u32be, uint32_t, 1)
+SBU_ARRAY_IMPL(i32le, int32_t, 0)
+SBU_ARRAY_IMPL(i32be, int32_t, 1)
+SBU_ARRAY_IMPL(u64le, uint64_t, 0)
+SBU_ARRAY_IMPL(u64be, uint64_t, 1)
+SBU_ARRAY_IMPL(i64le, int64_t, 0)
+SBU_ARRAY_IMPL(i64be, int64_t, 1)
+SBU_ARRAY_IMPL(f32le, float, 0)
+SBU_ARRAY_IMPL(f32be, float, 1)
+SBU_ARRAY_IMPL(f64le, double, 0)
+SBU_ARRAY_IMPL(f64be, double, 1)
+
+// Арена и растущий построитель
+
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_THREADS__)
+#define SBU_THREAD_LOCAL _Thread_local
+#elif defined(__GNUC__) || defined(__clang__)
+#define SBU_THREAD_LOCAL __thread
+#else
+#define SBU_THREAD_LOCAL
+#endif
+
+#define SBU_DYN_MIN 64
+
+void sbu_arena_init(sbu_arena_t *arena, void *mem, size_t size)
+{
+    if (!arena) return;
+    arena->base = (uint8_t *)mem;
+    arena->size = mem ? size : 0;
+    arena->used = 0;
+}
+
+void sbu_arena_reset(sbu_arena_t *arena)
+{
+    if (arena) arena->used = 0;
+}
+
+sbu_arena_t *sbu_arena_thread(void)
+{
+    // Память slab живет до конца процесса: освобождать ее при выходе
+    // потока в переносимом C нечем
+    static SBU_THREAD_LOCAL sbu_arena_t slab;
+    if (!slab.base)
+    {
+        void *mem = malloc(SBU_THREAD_SLAB);
+        if (!mem) return NULL;
+        sbu_arena_init(&slab, mem, SBU_THREAD_SLAB);
+    }
+    return &slab;
+}
+
+static bool sbu_dyn_on_top(const sbu_dyn_t *dyn)
+{
+    const sbu_arena_t *a = dyn->arena;
+    return dyn->buf.end == a->base + a->used;
+}
+
+static void sbu_dyn_fail(sbu_dyn_t *dyn)
+{
+    sbu_dyn_discard(dyn);
+    dyn->failed = true;
+}
+
+bool sbu_dyn_init(sbu_dyn_t *dyn, sbu_arena_t *arena, size_t hint)
+{
+    if (!dyn) return false;
+    dyn->buf.ptr = dyn->buf.end = dyn->base = NULL;
+    dyn->arena = arena;
+    dyn->failed = false;
+    if (hint < SBU_DYN_MIN) hint = SBU_DYN_MIN;
+
+    if (arena)
+    {
+        // Пустой кадр на вершине арены: первый grow вырастет на месте
+        if (!arena->base) { dyn->failed = true; return false; }
+        dyn->base = dyn->buf.ptr = dyn->buf.end = arena->base + arena->used;
+    }
+    return sbu_dyn_grow(dyn, hint);
+}
+
+bool sbu_dyn_grow(sbu_dyn_t *dyn, size_t n)
+{
+    size_t used, cap, need, want;
+    uint8_t *mem;
+
+    if (!dyn || dyn->failed) return false;
+    used = sbu_dyn_size(dyn);
+    cap = (size_t)(dyn->buf.end - dyn->base);
+    if (cap - used >= n) return true;
+    need = used + n;
+    if (need < used) { sbu_dyn_fail(dyn); return false; }
+    want = cap * 2 > need ? cap * 2 : need;
+    if (want < SBU_DYN_MIN) want = SBU_DYN_MIN;
+
+    if (!dyn->arena)
+    {
+        mem = (uint8_t *)realloc(dyn->base, want);
+        if (!mem) { sbu_dyn_fail(dyn); return false; }
+    }
+    else
+    {
+        sbu_arena_t *a = dyn->arena;
+        if (sbu_dyn_on_top(dyn))
+        {
+            // На вершине: просто сдвинуть used, удвоение ограничено остатком
+            size_t start = (size_t)(dyn->base - a->base);
+            size_t room = a->size - start;
+            if (room < need) { sbu_dyn_fail(dyn); return false; }
+            if (want > room) want = room;
+            a->used = start + want;
+            mem = dyn->base;
+        }
+        else
+        {
+            // Поверх кадра выделили что-то еще: перенос на вершину
+            size_t room = a->size - a->used;
+            if (room < need) { sbu_dyn_fail(dyn); return false; }
+            if (want > room) want = room;
+            mem = a->base + a->used;
+            if (used) memcpy(mem, dyn->base, used);
+            a->used += want;
+        }
+    }
+
+    dyn->base = mem;
+    dyn->buf.ptr = mem + used;
+    dyn->buf.end = mem + want;
+    return true;
+}
+
+sbu_t sbu_dyn_finish(sbu_dyn_t *dyn)
+{
+    sbu_t frame = {NULL, NULL};
+    if (!dyn || dyn->failed) return frame;
+
+    if (dyn->arena && sbu_dyn_on_top(dyn))
+        dyn->arena->used = (size_t)(dyn->buf.ptr - dyn->arena->base);
+    frame.ptr = dyn->base;
+    frame.end = dyn->buf.ptr;
+    // Построитель больше не владеет памятью
+    dyn->base = dyn->buf.ptr = dyn->buf.end = NULL;
+    return frame;
+}
+
+void sbu_dyn_discard(sbu_dyn_t *dyn)
+{
+    if (!dyn) return;
+    if (!dyn->arena)
+        free(dyn->base);
+    else if (dyn->base && sbu_dyn_on_top(dyn))
+        dyn->arena->used = (size_t)(dyn->base - dyn->arena->base);
+    dyn->base = dyn->buf.ptr = dyn->buf.end = NULL;
+}
+
+// Каналы 11 бит: группа из 8 каналов - 88 бит = 11 байт. Каналы 0-4
+// лежат в битах 0..54 первых 8 байт, каналы 5-7 - в битах 31..63 слова
+// с байта 3 (байты 3..10), так что выход за группу не нужен
+
+static void sbu_unpack_ch11x8(uint16_t *ch, const uint8_t *p)
+{
+    uint64_t a = SBU_TO_LE64(sbu_load64(p));
+    uint64_t b = SBU_TO_LE64(sbu_load64(p + 3));
+    ch[0] = (uint16_t)(a & 0x7FF);
+    ch[1] = (uint16_t)((a >> 11) & 0x7FF);
+    ch[2] = (uint16_t)((a >> 22) & 0x7FF);
+    ch[3] = (uint16_t)((a >> 33) & 0x7FF);
+    ch[4] = (uint16_t)((a >> 44) & 0x7FF);
+    ch[5] = (uint16_t)((b >> 31) & 0x7FF);
+    ch[6] = (uint16_t)((b >> 42) & 0x7FF);
+    ch[7] = (uint16_t)((b >> 53) & 0x7FF);
+}
+
+static void sbu_pack_ch11x8(uint8_t *p, const uint16_t *ch)
+{
+    uint64_t c5 = ch[5] & 0x7FFu;
+    uint64_t a = (uint64_t)(ch[0] & 0x7FFu) | ((uint64_t)(ch[1] & 0x7FFu) << 11) |
+                 ((uint64_t)(ch[2] & 0x7FFu) << 22) | ((uint64_t)(ch[3] & 0x7FFu) << 33) |
+                 ((uint64_t)(ch[4] & 0x7FFu) << 44) | (c5 << 55);
+    uint32_t b = (uint32_t)(c5 >> 9) | ((uint32_t)(ch[6] & 0x7FFu) << 2) | ((uint32_t)(ch[7] & 0x7FFu) << 13);
+    sbu_store64(p, SBU_TO_LE64(a));
+    p[8] = (uint8_t)b;
+    p[9] = (uint8_t)(b >> 8);
+    p[10] = (uint8_t)(b >> 16);
+}
+
+void sbu_pack_ch11x16(uint8_t *dst, const uint16_t *ch)
+{
+    sbu_pack_ch11x8(dst, ch);
+    sbu_pack_ch11x8(dst + 11, ch + 8);
+}
+
+void sbu_unpack_ch11x16(uint16_t *ch, const uint8_t *src)
+{
+    sbu_unpack_ch11x8(ch, src);
+    sbu_unpack_ch11x8(ch + 8, src + 11);
+}
+
+// Base64 и hex
+
+static const char sbu_b64_std[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+static const char sbu_b64_url[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+// Значение символа base64: 0xFF - не символ алфавита, 0x40 - только в
+// обычном алфавите ('+', '/'), 0x80 - только в URL-safe ('-', '_')
+static const uint8_t sbu_b64_table[256] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x7E, 0xFF, 0xBE, 0xFF, 0x7F,
+    0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+    0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xFF, 0xFF, 0xFF, 0xFF, 0xBF,
+    0xFF, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F, 0x30, 0x31, 0x32, 0x33, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+};
+
+// Биты, запрещенные для выбранного алфавита (0xFF задевает оба)
+#define SBU_B64_BAD(flags) (((flags) & SBU_BASE64_URL) ? 0x40u : 0x80u)
+
+#if defined(__SSSE3__) || defined(__AVX2__)
+// 12 байт (в 16-байтовой загрузке) -> 16 индексов по 6 бит (W. Mula)
+static __m128i sbu_b64_split(__m128i in)
+{
+    __m128i t0, t1, t2, t3;
+    in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+    t0 = _mm_and_si128(in, _mm_set1_epi32(0x0FC0FC00));
+    t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    t2 = _mm_and_si128(in, _mm_set1_epi32(0x003F03F0));
+    t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+    return _mm_or_si128(t1, t3);
+}
+
+// Индекс -> символ: номер диапазона (A-Z, a-z, 0-9, 62, 63) и pshufb по сдвигам
+static __m128i sbu_b64_lookup(__m128i idx, __m128i shift_lut)
+{
+    __m128i range = _mm_subs_epu8(idx, _mm_set1_epi8(51));
+    __m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), idx);
+    range = _mm_or_si128(range, _mm_and_si128(less, _mm_set1_epi8(13)));
+    return _mm_add_epi8(idx, _mm_shuffle_epi8(shift_lut, range));
+}
+
+static __m128i sbu_b64_shift_lut(int flags)
+{
+    char c62 = (flags & SBU_BASE64_URL) ? '-' : '+';
+    char c63 = (flags & SBU_BASE64_URL) ? '_' : '/';
+    return _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                         '0' - 52, '0' - 52, '0' - 52, (char)(c62 - 62), (char)(c63 - 63), 'A', 0, 0);
+}
+
+// 16 символов -> 12 байт в младших байтах; false - недопустимый символ.
+// Проверка и перевод по таблицам старшего/младшего полубайта (aklomp/base64).
+// URL-алфавит сначала переводится в обычный, а '+' и '/' в нем запрещены
+static bool sbu_b64_unpack(__m128i str, int flags, __m128i *out)
+{
+    const __m128i lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                         0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m128i lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                         0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i mask_2f = _mm_set1_epi8(0x2F);
+    __m128i hi_nib, lo_nib, hi, lo, roll, merged;
+
+    if (flags & SBU_BASE64_URL)
+    {
+        __m128i std_chars = _mm_or_si128(_mm_cmpeq_epi8(str, _mm_set1_epi8('+')), _mm_cmpeq_epi8(str, mask_2f));
+        if (_mm_movemask_epi8(std_chars)) return false;
+        str = _mm_add_epi8(str, _mm_and_si128(_mm_cmpeq_epi8(str, _mm_set1_epi8('-')), _mm_set1_epi8('+' - '-')));
+        str = _mm_add_epi8(str, _mm_and_si128(_mm_cmpeq_epi8(str, _mm_set1_epi8('_')), _mm_set1_epi8('/' - '_')));
+    }
+
+    hi_nib = _mm_and_si128(_mm_srli_epi32(str, 4), mask_2f);
+    lo_nib = _mm_and_si128(str, mask_2f);
+    hi = _mm_shuffle_epi8(lut_hi, hi_nib);
+    lo = _mm_shuffle_epi8(lut_lo, lo_nib);
+    if (_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128()))) return false;
+
+    roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(_mm_cmpeq_epi8(str, mask_2f), hi_nib));
+    str = _mm_add_epi8(str, roll);
+    merged = _mm_maddubs_epi16(str, _mm_set1_epi32(0x01400140));
+    merged = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+    *out = _mm_shuffle_epi8(merged, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    return true;
+}
+#endif
+
+bool sbu_base64_encode(sbu_t *dst, const void *data, size_t len, int flags)
+{
+    const char *alphabet = (flags & SBU_BASE64_URL) ? sbu_b64_url : sbu_b64_std;
+    const uint8_t *src = (const uint8_t *)data;
+    size_t need = sbu_base64_encoded_size(len, flags);
+    size_t i = 0;
+    uint8_t *out;
+
+    if (!dst || (!data && len)) return false;
+    if ((size_t)sbu_left(dst) < need) return false;
+    out = dst->ptr;
+
+#if defined(__SSSE3__) || defined(__AVX2__)
+    {
+        __m128i lut = sbu_b64_shift_lut(flags);
+#if defined(__AVX2__)
+        __m256i lut2 = _mm256_broadcastsi128_si256(lut);
+        // 24 байта -> 32 символа; вторая половина читается с байта 12
+        for (; i + 28 <= len; i += 24, out += 32)
+        {
+            __m256i in = _mm256_inserti128_si256(
+                _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)(src + i))),
+                _mm_loadu_si128((const __m128i *)(src + i + 12)), 1);
+            __m256i t0, t1, t2, t3, idx, range, less;
+            in = _mm256_shuffle_epi8(in, _mm256_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+                                                         10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+            t0 = _mm256_and_si256(in, _mm256_set1_epi32(0x0FC0FC00));
+            t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+            t2 = _mm256_and_si256(in, _mm256_set1_epi32(0x003F03F0));
+            t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+            idx = _mm256_or_si256(t1, t3);
+            range = _mm256_subs_epu8(idx, _mm256_set1_epi8(51));
+            less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), idx);
+            range = _mm256_or_si256(range, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+            _mm256_storeu_si256((__m256i *)out, _mm256_add_epi8(idx, _mm256_shuffle_epi8(lut2, range)));
+        }
+#endif
+        // 16-байтовая загрузка, из нее используются 12
+        for (; i + 16 <= len; i += 12, out += 16)
+        {
+            __m128i idx = sbu_b64_split(_mm_loadu_si128((const __m128i *)(src + i)));
+            _mm_storeu_si128((__m128i *)out, sbu_b64_lookup(idx, lut));
+        }
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    {
+        uint8x16x4_t table;
+        table.val[0] = vld1q_u8((const uint8_t *)alphabet);
+        table.val[1] = vld1q_u8((const uint8_t *)alphabet + 16);
+        table.val[2] = vld1q_u8((const uint8_t *)alphabet + 32);
+        table.val[3] = vld1q_u8((const uint8_t *)alphabet + 48);
+        // vld3 раскладывает 48 байт по трем регистрам, vst4 собирает 64 символа
+        for (; i + 48 <= len; i += 48, out += 64)
+        {
+            uint8x16x3_t in = vld3q_u8(src + i);
+            uint8x16x4_t idx;
+            idx.val[0] = vshrq_n_u8(in.val[0], 2);
+            idx.val[1] = vandq_u8(vorrq_u8(vshlq_n_u8(in.val[0], 4), vshrq_n_u8(in.val[1], 4)), vdupq_n_u8(0x3F));
+            idx.val[2] = vandq_u8(vorrq_u8(vshlq_n_u8(in.val[1], 2), vshrq_n_u8(in.val[2], 6)), vdupq_n_u8(0x3F));
+            idx.val[3] = vandq_u8(in.val[2], vdupq_n_u8(0x3F));
+            idx.val[0] = vqtbl4q_u8(table, idx.val[0]);
+            idx.val[1] = vqtbl4q_u8(table, idx.val[1]);
+            idx.val[2] = vqtbl4q_u8(table, idx.val[2]);
+            idx.val[3] = vqtbl4q_u8(table, idx.val[3]);
+            vst4q_u8(out, idx);
+        }
+    }
+#endif
+
+    for (; i + 3 <= len; i += 3, out += 4)
+    {
+        uint32_t v = ((uint32_t)src[i] << 16) | ((uint32_t)src[i + 1] << 8) | src[i + 2];
+        out[0] = (uint8_t)alphabet[v >> 18];
+        out[1] = (uint8_t)alphabet[(v >> 12) & 0x3F];
+        out[2] = (uint8_t)alphabet[(v >> 6) & 0x3F];
+        out[3] = (uint8_t)alphabet[v & 0x3F];
+    }
+    if (i < len)
+    {
+        uint32_t v = (uint32_t)src[i] << 16;
+        if (i + 1 < len) v |= (uint32_t)src[i + 1] << 8;
+        *out++ = (uint8_t)alphabet[v >> 18];
+        *out++ = (uint8_t)alphabet[(v >> 12) & 0x3F];
+        if (i + 1 < len) *out++ = (uint8_t)alphabet[(v >> 6) & 0x3F];
+        else if (!(flags & SBU_BASE64_NOPAD)) *out++ = '=';
+        if (!(flags & SBU_BASE64_NOPAD)) *out++ = '=';
+    }
+
+    dst->ptr = out;
+    return true;
+}
+
+bool sbu_base64_decode(sbu_t *dst, const char *text, size_t len, int flags)
+{
+    const uint8_t *src = (const uint8_t *)text;
+    const uint32_t bad = SBU_B64_BAD(flags);
+    size_t i = 0, room, tail;
+    uint8_t *out;
+
+    if (!dst || (!text && len)) return false;
+    // '=' только в конце и только до кратной 4 длины
+    if (len && src[len - 1] == '=')
+    {
+        if (len % 4) return false;
+        len--;
+        if (src[len - 1] == '=') len--;
+    }
+    if (len % 4 == 1) return false;
+    room = (size_t)sbu_left(dst);
+    if (room < len / 4 * 3 + (len % 4 ? len % 4 - 1 : 0)) return false;
+    out = dst->ptr;
+
+#if defined(__SSSE3__) || defined(__AVX2__)
+    // Векторный блок пишет 16 (32) байт при 12 (24) полезных, поэтому идет,
+    // пока хватает запаса в dst. Ошибка в блоке - его разбирает скалярный
+    // код ниже и сообщает о ней
+#if defined(__AVX2__)
+    for (; i + 32 <= len && room - (size_t)(out - dst->ptr) >= 32; i += 32, out += 24)
+    {
+        __m128i a, b;
+        __m256i both;
+        if (!sbu_b64_unpack(_mm_loadu_si128((const __m128i *)(src + i)), flags, &a) ||
+            !sbu_b64_unpack(_mm_loadu_si128((const __m128i *)(src + i + 16)), flags, &b))
+            break;
+        both = _mm256_inserti128_si256(_mm256_castsi128_si256(a), b, 1);
+        both = _mm256_permutevar8x32_epi32(both, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+        _mm256_storeu_si256((__m256i *)out, both);
+    }
+#endif
+    for (; i + 16 <= len && room - (size_t)(out - dst->ptr) >= 16; i += 16, out += 12)
+    {
+        __m128i block;
+        if (!sbu_b64_unpack(_mm_loadu_si128((const __m128i *)(src + i)), flags, &block)) break;
+        _mm_storeu_si128((__m128i *)out, block);
+    }
+#endif
+
+    for (; i + 4 <= len; i += 4, out += 3)
+    {
+        uint32_t a = sbu_b64_table[src[i]], b = sbu_b64_table[src[i + 1]];
+        uint32_t c = sbu_b64_table[src[i + 2]], d = sbu_b64_table[src[i + 3]];
+        uint32_t v;
+        if ((a | b | c | d) & bad) return false;
+        v = ((a & 0x3F) << 18) | ((b & 0x3F) << 12) | ((c & 0x3F) << 6) | (d & 0x3F);
+        out[0] = (uint8_t)(v >> 16);
+        out[1] = (uint8_t)(v >> 8);
+        out[2] = (uint8_t)v;
+    }
+    tail = len - i;
+    if (tail)
+    {
+        // 2 или 3 символа; неиспользуемые младшие биты должны быть нулями
+        uint32_t a = sbu_b64_table[src[i]], b = sbu_b64_table[src[i + 1]];
+        uint32_t c = tail == 3 ? sbu_b64_table[src[i + 2]] : 0;
+        uint32_t v;
+        if ((a | b | c) & bad) return false;
+        v = ((a & 0x3F) << 18) | ((b & 0x3F) << 12) | ((c & 0x3F) << 6);
+        if (v & (tail == 3 ? 0xFFu : 0xFFFFu)) return false;
+        *out++ = (uint8_t)(v >> 16);
+        if (tail == 3) *out++ = (uint8_t)(v >> 8);
+    }
+
+    dst->ptr = out;
+    return true;
+}
+
+bool sbu_hex_encode(sbu_t *dst, const void *data, size_t len, int flags)
+{
+    const char *digits = (flags & SBU_HEX_UPPER) ? "0123456789ABCDEF" : "0123456789abcdef";
+    const uint8_t *src = (const uint8_t *)data;
+    size_t i = 0;
+    uint8_t *out;
+
+    if (!dst || (!data && len)) return false;
+    if ((size_t)sbu_left(dst) / 2 < len) return false;
+    out = dst->ptr;
+
+#if defined(__SSE2__)
+    {
+        // Полубайт -> '0' + n, для n > 9 еще + ('a' - '0' - 10)
+        const __m128i mask = _mm_set1_epi8(0x0F);
+        const __m128i nine = _mm_set1_epi8(9);
+        const __m128i letter = _mm_set1_epi8((char)(((flags & SBU_HEX_UPPER) ? 'A' : 'a') - '0' - 10));
+        for (; i + 16 <= len; i += 16, out += 32)
+        {
+            __m128i in = _mm_loadu_si128((const __m128i *)(src + i));
+            __m128i hi = _mm_and_si128(_mm_srli_epi16(in, 4), mask);
+            __m128i lo = _mm_and_si128(in, mask);
+            hi = _mm_add_epi8(_mm_add_epi8(hi, _mm_set1_epi8('0')), _mm_and_si128(_mm_cmpgt_epi8(hi, nine), letter));
+            lo = _mm_add_epi8(_mm_add_epi8(lo, _mm_set1_epi8('0')), _mm_and_si128(_mm_cmpgt_epi8(lo, nine), letter));
+            _mm_storeu_si128((__m128i *)out, _mm_unpacklo_epi8(hi, lo));
+            _mm_storeu_si128((__m128i *)(out + 16), _mm_unpackhi_epi8(hi, lo));
+        }
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    {
+        const uint8x16_t table = vld1q_u8((const uint8_t *)digits);
+        for (; i + 16 <= len; i += 16, out += 32)
+        {
+            uint8x16_t in = vld1q_u8(src + i);
+            uint8x16x2_t pair;
+            pair.val[0] = vqtbl1q_u8(table, vshrq_n_u8(in, 4));
+            pair.val[1] = vqtbl1q_u8(table, vandq_u8(in, vdupq_n_u8(0x0F)));
+            vst2q_u8(out, pair);
+        }
+    }
+#endif
+
+    for (; i < len; i++)
+    {
+        *out++ = (uint8_t)digits[src[i] >> 4];
+        *out++ = (uint8_t)digits[src[i] & 0x0F];
+    }
+    dst->ptr = out;
+    return true;
+}
+
+static int sbu_hex_value(uint8_t c)
+{
+    uint8_t d = (uint8_t)(c - '0');
+    uint8_t l = (uint8_t)((c | 0x20) - 'a');
+    if (d <= 9) return d;
+    if (l <= 5) return l + 10;
+    return -1;
+}
+
+bool sbu_hex_decode(sbu_t *dst, const char *text, size_t len)
+{
+    const uint8_t *src = (const uint8_t *)text;
+    size_t i = 0;
+    uint8_t *out;
+
+    if (!dst || (!text && len) || (len & 1)) return false;
+    if ((size_t)sbu_left(dst) < len / 2) return false;
+    out = dst->ptr;
+
+#if defined(__SSE2__)
+    {
+        // Цифра: c - '0' <= 9; буква: (c | 0x20) - 'a' <= 5. Сравнение без
+        // знака через min_epu8. Пары символов склеиваются в 16-битных словах
+        const __m128i zero = _mm_set1_epi8('0');
+        const __m128i a = _mm_set1_epi8('a');
+        for (; i + 32 <= len; i += 32, out += 16)
+        {
+            __m128i v[2];
+            int k, bad = 0;
+            for (k = 0; k < 2; k++)
+            {
+                __m128i c = _mm_loadu_si128((const __m128i *)(src + i + 16 * k));
+                __m128i d = _mm_sub_epi8(c, zero);
+                __m128i l = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), a);
+                __m128i is_d = _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(9)), d);
+                __m128i is_l = _mm_cmpeq_epi8(_mm_min_epu8(l, _mm_set1_epi8(5)), l);
+                bad |= _mm_movemask_epi8(_mm_or_si128(is_d, is_l)) ^ 0xFFFF;
+                v[k] = _mm_or_si128(_mm_and_si128(is_d, d),
+                                    _mm_and_si128(is_l, _mm_add_epi8(l, _mm_set1_epi8(10))));
+                // Слово: младший байт - старший полубайт, старший байт - младший
+                v[k] = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(v[k], _mm_set1_epi16(0x00FF)), 4),
+                                    _mm_srli_epi16(v[k], 8));
+            }
+            if (bad) return false;
+            _mm_storeu_si128((__m128i *)out, _mm_packus_epi16(v[0], v[1]));
+        }
+    }
+#endif
+
+    for (; i < len; i += 2)
+    {
+        int hi = sbu_hex_value(src[i]), lo = sbu_hex_value(src[i + 1]);
+        if ((hi | lo) < 0) return false;
+        *out++ = (uint8_t)((hi << 4) | lo);
+    }
+    dst->ptr = out;
+    return true;
+}
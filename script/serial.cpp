@@ -1,7 +1,26 @@
 #ifndef ARDUINO
 #include "serial.hpp"
+#include <time.h>
+#include <stdio.h>
 
-uSerial::uSerial() : m_fd(-1), m_is_external(false) {}
+static inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+uSerial::uSerial()
+    : m_fd(-1), m_is_external(false), m_baudrate(0), m_packet_gap_us(0), m_packet_max(USERIAL_PACKET_MAX),
+      m_spin_us(0), m_latency_enabled(false), m_ready_ns(0), m_latency_count(0),
+      m_spin_hits(0), m_blocking_waits(0)
+{
+#if defined(__linux__) && HAS_TERMIOS2
+    m_tio2_valid = false;
+#endif
+}
 
 uSerial::~uSerial()
 {
@@ -45,10 +64,65 @@ bool uSerial::open(const char *port, unsigned long baudrate)
 
     LOG_INFO_F("uSerial port '%s' opened successfully at %ld baud",
                port_str.c_str(), baudrate);
+    STREAM_STAT_OPEN();
 
     return configureSerial(baudrate);
 }
 
+bool uSerial::openPty(uSerial &master, uSerial &slave, unsigned long baudrate)
+{
+#ifdef __linux__
+    master.close();
+    slave.close();
+
+    int master_fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master_fd < 0)
+    {
+        LOG_ERROR_F("posix_openpt failed: %s", strerror(errno));
+        return false;
+    }
+
+    char name[64];
+    if (grantpt(master_fd) != 0 || unlockpt(master_fd) != 0 ||
+        ptsname_r(master_fd, name, sizeof(name)) != 0)
+    {
+        LOG_ERROR_F("Failed to unlock pty: %s", strerror(errno));
+        ::close(master_fd);
+        return false;
+    }
+
+    int slave_fd = ::open(name, O_RDWR | O_NOCTTY);
+    if (slave_fd < 0)
+    {
+        LOG_ERROR_F("Failed to open pty slave '%s': %s", name, strerror(errno));
+        ::close(master_fd);
+        return false;
+    }
+
+    // begin(fd) помечает fd внешним, забираем владение себе. slave
+    // получает fd и при ошибке master, чтобы close() закрыл оба
+    bool ok = master.begin(master_fd, baudrate);
+    master.m_is_external = false;
+    ok = slave.begin(slave_fd, baudrate) && ok;
+    slave.m_is_external = false;
+    if (!ok)
+    {
+        LOG_ERROR_F("Failed to configure pty pair at %lu baud", baudrate);
+        master.close();
+        slave.close();
+        return false;
+    }
+
+    LOG_INFO_F("pty pair opened, slave '%s'", name);
+    return true;
+#else
+    (void)master;
+    (void)slave;
+    (void)baudrate;
+    return false;
+#endif
+}
+
 bool uSerial::begin(int fd)
 {
     if (!m_is_external && m_fd >= 0)
@@ -57,7 +131,12 @@ bool uSerial::begin(int fd)
     }
     m_fd = fd;
     m_is_external = true;
-    return (m_fd >= 0);
+    m_baudrate = 0;
+    cacheTermios();
+    if (m_fd < 0)
+        return false;
+    STREAM_STAT_OPEN();
+    return true;
 }
 
 bool uSerial::begin(int fd, unsigned long baudrate)
@@ -75,51 +154,126 @@ void uSerial::close()
     {
         ::close(m_fd);
         m_fd = -1;
+        cacheTermios();
     }
 }
 
-int uSerial::available() const
-{
-    if (m_fd < 0)
-        return 0;
-
-    int bytes_available = 0;
-    ioctl(m_fd, FIONREAD, &bytes_available);
-    return bytes_available;
-}
-
 uint8_t uSerial::read()
 {
     if (m_fd < 0)
         return -1;
 
     uint8_t byte;
+    if (takeStaged(&byte, 1) == 1)
+    {
+        STREAM_STAT_DELIVERED(1);
+        return byte;
+    }
+    STREAM_STAT_ADD(STREAM_STAT_SYSCALLS, 1);
     if (::read(m_fd, &byte, 1) == 1)
     {
+        recordLatency();
+        STREAM_STAT_DELIVERED(1);
         return byte;
     }
     return -1;
 }
 
-size_t uSerial::read(uint8_t *buffer, size_t length)
+size_t uSerial::write(uint8_t byte)
 {
-    if (m_fd < 0 || !buffer || length == 0)
+    if (m_fd < 0)
         return 0;
-    return ::read(m_fd, buffer, length);
+    ssize_t n = ::write(m_fd, &byte, 1);
+    STREAM_STAT_ADD(STREAM_STAT_SYSCALLS, 1);
+    if (n == 1)
+    {
+        STREAM_STAT_ADD(STREAM_STAT_OPS_OUT, 1);
+        STREAM_STAT_ADD(STREAM_STAT_BYTES_OUT, 1);
+    }
+    return n == 1 ? 1 : 0;
 }
 
-size_t uSerial::write(uint8_t byte)
+size_t uSerial::writev(const struct iovec *iov, int iovcnt)
 {
-    if (m_fd < 0)
+    if (m_fd < 0 || !iov || iovcnt <= 0)
         return 0;
-    return ::write(m_fd, &byte, 1);
+    STREAM_STAT_START(started);
+    STREAM_TRACE_START(trace_started);
+    ssize_t n = ::writev(m_fd, iov, iovcnt);
+    STREAM_TRACE_SPAN(TRACE_SERIAL_WRITE, trace_started, m_fd, n);
+    STREAM_STAT_WRITE_DONE(started);
+    STREAM_STAT_ADD(STREAM_STAT_SYSCALLS, 1);
+#if STREAM_STATS
+    if (n > 0)
+    {
+        size_t total = 0;
+        for (int i = 0; i < iovcnt; i++)
+            total += iov[i].iov_len;
+        m_stats.add(STREAM_STAT_OPS_OUT);
+        m_stats.add(STREAM_STAT_BYTES_OUT, n);
+        if ((size_t)n < total)
+            m_stats.add(STREAM_STAT_PARTIAL_WRITES);
+    }
+#endif
+    return n > 0 ? (size_t)n : 0;
 }
 
-size_t uSerial::write(const uint8_t *buffer, size_t length)
+size_t uSerial::readv(const struct iovec *iov, int iovcnt)
 {
-    if (m_fd < 0 || !buffer || length == 0)
+    if (m_fd < 0 || !iov || iovcnt <= 0)
         return 0;
-    return ::write(m_fd, buffer, length);
+    if (stagedRead() > 0)
+    {
+        // Остаток окна acquireRead; за новыми данными - следующим вызовом
+        size_t total = 0;
+        for (int i = 0; i < iovcnt && stagedRead() > 0; i++)
+            total += takeStaged(static_cast<uint8_t *>(iov[i].iov_base), iov[i].iov_len);
+        STREAM_STAT_DELIVERED(total);
+        return total;
+    }
+    STREAM_TRACE_START(trace_started);
+    ssize_t n = ::readv(m_fd, iov, iovcnt);
+    STREAM_TRACE_SPAN(TRACE_SERIAL_READ, trace_started, m_fd, n);
+    STREAM_STAT_ADD(STREAM_STAT_SYSCALLS, 1);
+    if (n <= 0)
+        return 0;
+    recordLatency();
+    STREAM_STAT_DELIVERED(n);
+    return (size_t)n;
+}
+
+sbu_t uSerial::acquireRead(size_t min)
+{
+    if (m_fd < 0)
+        return makeView(nullptr, 0);
+    if (min == 0)
+        min = 1;
+
+    if (stagedRead() < min)
+    {
+        // Одним ::read забираем все уже пришедшее, но не меньше недостающего
+        int bytes_available = 0;
+        ioctl(m_fd, FIONREAD, &bytes_available);
+        size_t want = std::max((size_t)std::max(bytes_available, 0), min - stagedRead());
+        uint8_t *dst = growStage(want);
+        STREAM_TRACE_START(trace_started);
+        ssize_t n = ::read(m_fd, dst, want);
+        STREAM_TRACE_SPAN(TRACE_SERIAL_READ, trace_started, m_fd, n);
+        m_rx_stage.resize(m_rx_stage.size() - want + (n > 0 ? (size_t)n : 0));
+        STREAM_STAT_ADD(STREAM_STAT_SYSCALLS, 1);
+        if (n > 0)
+            recordLatency();
+        if (stagedRead() < min)
+            return makeView(nullptr, 0);
+    }
+    return makeView(m_rx_stage.data() + m_rx_stage_head, stagedRead());
+}
+
+void uSerial::releaseRead(size_t n)
+{
+    n = std::min(n, stagedRead());
+    releaseStaged(n);
+    STREAM_STAT_DELIVERED(n);
 }
 
 void uSerial::flush()
@@ -128,6 +282,7 @@ void uSerial::flush()
     {
         tcdrain(m_fd);
         tcflush(m_fd, TCIOFLUSH);
+        releaseStaged(stagedRead());
     }
 }
 
@@ -139,14 +294,49 @@ bool uSerial::poll(int timeout_ms)
     struct pollfd pfd;
     pfd.fd = m_fd;
     pfd.events = POLLIN;
+    STREAM_STAT_START(wait_started);
+    STREAM_TRACE_START(trace_started);
 
-    int ret = ::poll(&pfd, 1, timeout_ms);
-    return (ret > 0 && (pfd.revents & POLLIN));
-}
+    if (m_spin_us > 0 && timeout_ms != 0)
+    {
+        uint64_t start = uClock::realNs();
+        uint64_t budget = (uint64_t)m_spin_us * 1000ULL;
+        if (timeout_ms > 0)
+            budget = std::min<uint64_t>(budget, (uint64_t)timeout_ms * 1000000ULL);
 
-bool uSerial::isOpen() const
-{
-    return m_fd >= 0;
+        uint64_t now = start;
+        do
+        {
+            STREAM_STAT_ADD(STREAM_STAT_SYSCALLS, 1);
+            if (::poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLIN))
+            {
+                markReady(true);
+                STREAM_STAT_WAIT_DONE(wait_started);
+                STREAM_TRACE_SPAN(TRACE_SERIAL_POLL, trace_started, m_fd, 1);
+                return true;
+            }
+            cpu_relax();
+            now = uClock::realNs();
+        } while (now - start < budget);
+
+        if (timeout_ms > 0)
+        {
+            int spent_ms = (int)((now - start) / 1000000ULL);
+            timeout_ms = std::max(timeout_ms - spent_ms, 0);
+        }
+    }
+
+    int ret = ::poll(&pfd, 1, timeout_ms);
+    STREAM_STAT_ADD(STREAM_STAT_SYSCALLS, 1);
+    if (timeout_ms != 0)
+        STREAM_STAT_WAIT_DONE(wait_started);
+    STREAM_TRACE_SPAN(TRACE_SERIAL_POLL, trace_started, m_fd, ret > 0 && (pfd.revents & POLLIN));
+    if (ret > 0 && (pfd.revents & POLLIN))
+    {
+        markReady(false);
+        return true;
+    }
+    return false;
 }
 
 void uSerial::setLowLatency(bool enable)
@@ -173,6 +363,221 @@ void uSerial::setLowLatency(bool enable)
 #endif
 }
 
+bool uSerial::setLatencyTimer(uint8_t ms)
+{
+#ifdef __linux__
+    if (m_fd < 0 || ms == 0)
+        return false;
+
+    char link[32];
+    char dev[256];
+    snprintf(link, sizeof(link), "/proc/self/fd/%d", m_fd);
+    ssize_t len = readlink(link, dev, sizeof(dev) - 1);
+    if (len <= 0)
+        return false;
+    dev[len] = '\0';
+
+    const char *name = strrchr(dev, '/');
+    name = name ? name + 1 : dev;
+
+    char path[320];
+    snprintf(path, sizeof(path), "/sys/class/tty/%s/device/latency_timer", name);
+    int fd = ::open(path, O_WRONLY);
+    if (fd < 0)
+    {
+        LOG_WARN_F("No latency_timer for '%s': %s", name, strerror(errno));
+        return false;
+    }
+
+    char value[8];
+    int value_len = snprintf(value, sizeof(value), "%u", (unsigned)ms);
+    bool ok = ::write(fd, value, value_len) == value_len;
+    ::close(fd);
+    return ok;
+#else
+    (void)ms;
+    return false;
+#endif
+}
+
+void uSerial::enableLatencyStats(bool enable)
+{
+    m_latency_enabled = enable;
+    m_ready_ns = 0;
+    m_latency_count = 0;
+    m_spin_hits = 0;
+    m_blocking_waits = 0;
+    if (enable)
+        m_latency_samples.assign(USERIAL_LATENCY_WINDOW, 0);
+    else
+        std::vector<uint32_t>().swap(m_latency_samples);
+}
+
+void uSerial::markReady(bool spin)
+{
+    if (!m_latency_enabled)
+        return;
+    if (spin)
+        m_spin_hits++;
+    else
+        m_blocking_waits++;
+    if (m_ready_ns == 0)
+        m_ready_ns = uClock::realNs();
+}
+
+void uSerial::recordLatency()
+{
+    if (m_ready_ns == 0 || m_latency_samples.empty())
+        return;
+    uint64_t delta = uClock::realNs() - m_ready_ns;
+    m_ready_ns = 0;
+    m_latency_samples[m_latency_count % USERIAL_LATENCY_WINDOW] =
+        (uint32_t)std::min<uint64_t>(delta, UINT32_MAX);
+    m_latency_count++;
+}
+
+uSerialLatencyStats uSerial::latencyStats() const
+{
+    uSerialLatencyStats stats;
+    memset(&stats, 0, sizeof(stats));
+    stats.spin_hits = m_spin_hits;
+    stats.blocking_waits = m_blocking_waits;
+
+    uint32_t n = std::min<uint32_t>(m_latency_count, USERIAL_LATENCY_WINDOW);
+    if (n == 0)
+        return stats;
+
+    std::vector<uint32_t> sorted(m_latency_samples.begin(), m_latency_samples.begin() + n);
+    std::sort(sorted.begin(), sorted.end());
+
+    stats.samples = n;
+    stats.p50_ns = sorted[(n - 1) / 2];
+    stats.p99_ns = sorted[((uint64_t)(n - 1) * 99) / 100];
+    return stats;
+}
+
+bool uSerial::setPacketMode(uint32_t interbyte_us, size_t max_packet)
+{
+    if (max_packet == 0)
+        return false;
+    m_packet_gap_us = interbyte_us;
+    m_packet_max = max_packet;
+    return true;
+}
+
+size_t uSerial::readPacket(uint8_t *buffer, size_t length, int timeout_ms, uint64_t *timestamp_us)
+{
+    if (m_fd < 0 || !buffer || length == 0)
+        return 0;
+
+    if (stagedRead() > 0)
+    {
+        // Эти байты уже прочитаны из fd раньше новых: границы посылки у них
+        // не восстановить, поэтому они уходят отдельно, как в readv
+        size_t n = takeStaged(buffer, length);
+        if (timestamp_us)
+            *timestamp_us = uClock::nowUs();
+        STREAM_STAT_ADD(STREAM_STAT_FRAMES, 1);
+        STREAM_STAT_DELIVERED(n);
+        return n;
+    }
+
+    if (!poll(timeout_ms))
+        return 0;
+
+    if (m_packet_gap_us == 0)
+    {
+        // Без пакетного режима - обычное чтение
+        ssize_t n = ::read(m_fd, buffer, length);
+        STREAM_STAT_ADD(STREAM_STAT_SYSCALLS, 1);
+        if (n <= 0)
+            return 0;
+        recordLatency();
+        if (timestamp_us)
+            *timestamp_us = uClock::nowUs();
+        STREAM_STAT_ADD(STREAM_STAT_FRAMES, 1);
+        STREAM_STAT_DELIVERED(n);
+        return (size_t)n;
+    }
+
+    struct pollfd pfd;
+    pfd.fd = m_fd;
+    pfd.events = POLLIN;
+
+#ifdef __linux__
+    struct timespec gap;
+    gap.tv_sec = m_packet_gap_us / 1000000UL;
+    gap.tv_nsec = (long)(m_packet_gap_us % 1000000UL) * 1000L;
+#else
+    int gap_ms = (int)((m_packet_gap_us + 999) / 1000);
+#endif
+
+    size_t received = 0;
+    uint64_t last_rx = 0;
+    STREAM_TRACE_START(trace_started);
+    while (received < length)
+    {
+        ssize_t n = ::read(m_fd, buffer + received, length - received);
+        STREAM_STAT_ADD(STREAM_STAT_SYSCALLS, 1);
+        if (n > 0)
+        {
+            if (received == 0)
+                recordLatency();
+            received += (size_t)n;
+            last_rx = uClock::nowUs();
+            if (received == length)
+                break;
+        }
+        else if (n < 0 && errno != EINTR && errno != EAGAIN)
+        {
+            break;
+        }
+
+        // Ждем следующий байт не дольше межбайтовой паузы
+#ifdef __linux__
+        int ret = ::ppoll(&pfd, 1, &gap, nullptr);
+#else
+        int ret = ::poll(&pfd, 1, gap_ms);
+#endif
+        STREAM_STAT_ADD(STREAM_STAT_SYSCALLS, 1);
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret <= 0 || !(pfd.revents & POLLIN))
+            break;
+    }
+
+    if (timestamp_us && received > 0)
+        *timestamp_us = last_rx;
+    STREAM_TRACE_SPAN(TRACE_SERIAL_PACKET, trace_started, m_fd, received);
+    if (received > 0)
+    {
+        STREAM_STAT_ADD(STREAM_STAT_FRAMES, 1);
+        STREAM_STAT_DELIVERED(received);
+    }
+    return received;
+}
+
+size_t uSerial::dispatch(int timeout_ms)
+{
+    if (m_packet_gap_us == 0 || stagedRead() > 0)
+        return uStream::dispatch(timeout_ms);
+    if (!hasCallbacks())
+        return 0;
+
+    if (m_packet_buf.size() != m_packet_max)
+        m_packet_buf.resize(m_packet_max);
+
+    size_t length = readPacket(m_packet_buf.data(), m_packet_buf.size(), timeout_ms);
+    if (length == m_packet_max)
+        LOG_WARN_F("Packet reached %zu bytes, the rest goes to the next message", m_packet_max);
+    if (length > 0)
+    {
+        dispatchData(m_packet_buf.data(), length);
+        dispatchMessage(m_packet_buf.data(), length);
+    }
+    return length;
+}
+
 bool uSerial::configureSerial(unsigned long baudrate)
 {
     struct termios options;
@@ -196,11 +601,142 @@ bool uSerial::configureSerial(unsigned long baudrate)
         if (tcsetattr(m_fd, TCSANOW, &options) == 0)
         {
             setLowLatency(true);
+            m_baudrate = baudrate;
+            cacheTermios();
             return true;
         }
     }
 
-    return setCustomBaudrate(baudrate);
+    if (!setCustomBaudrate(baudrate))
+        return false;
+    m_baudrate = baudrate;
+    cacheTermios();
+    return true;
+}
+
+void uSerial::cacheTermios()
+{
+#if defined(__linux__) && HAS_TERMIOS2
+    m_tio2_valid = m_fd >= 0 && ioctl(m_fd, TCGETS2, &m_tio2) == 0;
+#endif
+}
+
+bool uSerial::setBaudrate(unsigned long baudrate, bool drain)
+{
+    if (m_fd < 0 || baudrate == 0)
+        return false;
+    if (baudrate == m_baudrate)
+        return true;
+
+    if (drain)
+        tcdrain(m_fd);
+
+#if defined(__linux__) && HAS_TERMIOS2
+    if (!m_tio2_valid)
+        cacheTermios();
+    if (m_tio2_valid)
+    {
+        struct termios2 tio = m_tio2;
+        tio.c_cflag &= ~CBAUD;
+        tio.c_cflag |= BOTHER;
+        tio.c_ispeed = baudrate;
+        tio.c_ospeed = baudrate;
+
+        if (ioctl(m_fd, TCSETS2, &tio) == 0)
+        {
+            m_tio2 = tio;
+            m_baudrate = baudrate;
+            return true;
+        }
+        LOG_WARN_F("TCSETS2 failed for %lu baud: %s", baudrate, strerror(errno));
+    }
+#elif defined(__APPLE__)
+    if (setCustomBaudrateMacOS(baudrate))
+    {
+        m_baudrate = baudrate;
+        return true;
+    }
+#endif
+
+    // Запасной путь: только скорость, без cfmakeraw и сброса остальных флагов
+    speed_t speed = getBaudRateConstant(baudrate);
+    struct termios options;
+    if (speed != B0 && tcgetattr(m_fd, &options) == 0)
+    {
+        cfsetispeed(&options, speed);
+        cfsetospeed(&options, speed);
+        if (tcsetattr(m_fd, TCSANOW, &options) == 0)
+        {
+            m_baudrate = baudrate;
+            cacheTermios();
+            return true;
+        }
+    }
+
+    LOG_ERROR_F("Failed to switch baudrate to %lu", baudrate);
+    return false;
+}
+
+bool uSerial::negotiateBaudrate(unsigned long baudrate,
+                                const uint8_t *request, size_t request_len,
+                                const uint8_t *ack, size_t ack_len,
+                                uint32_t timeout_ms)
+{
+    if (m_fd < 0 || !request || request_len == 0)
+        return false;
+    if (!ack || ack_len == 0)
+    {
+        LOG_ERROR("negotiateBaudrate needs an ack, use requestBaudrate to switch unconfirmed");
+        return false;
+    }
+
+    // Префикс-функция ack: при несовпадении откатываемся на самый длинный
+    // собственный префикс, который еще может продолжиться ("AAB" в "AAAB")
+    std::vector<size_t> fail(ack_len, 0);
+    for (size_t i = 1, k = 0; i < ack_len; i++)
+    {
+        while (k > 0 && ack[i] != ack[k])
+            k = fail[k - 1];
+        if (ack[i] == ack[k])
+            k++;
+        fail[i] = k;
+    }
+
+    if (write(request, request_len) != request_len)
+        return false;
+
+    // Ищем ack в потоке: перед ним могут прийти хвосты старых кадров
+    size_t matched = 0;
+    uint32_t start_time = millis();
+    while (matched < ack_len)
+    {
+        uint32_t elapsed = millis() - start_time;
+        if (elapsed >= timeout_ms || !poll((int)(timeout_ms - elapsed)))
+        {
+            LOG_WARN_F("No baudrate ack from peer, staying at %lu", m_baudrate);
+            return false;
+        }
+
+        uint8_t byte;
+        if (::read(m_fd, &byte, 1) != 1)
+            continue;
+        recordLatency();
+        while (matched > 0 && byte != ack[matched])
+            matched = fail[matched - 1];
+        if (byte == ack[matched])
+            matched++;
+    }
+
+    return setBaudrate(baudrate, true);
+}
+
+bool uSerial::requestBaudrate(unsigned long baudrate, const uint8_t *request, size_t request_len)
+{
+    if (m_fd < 0 || !request || request_len == 0)
+        return false;
+    if (write(request, request_len) != request_len)
+        return false;
+    return setBaudrate(baudrate, true);
 }
 
 speed_t uSerial::getBaudRateConstant(unsigned long baudrate)
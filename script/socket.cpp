@@ -14,42 +14,51 @@
 #include <sys/ioctl.h>
 #include <poll.h>
 
-static std::string base64_encode(const std::string& input) {
-    static const char* base64_chars = 
-        "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-        "abcdefghijklmnopqrstuvwxyz"
-        "0123456789+/";
-    
-    std::string output;
-    int val = 0, valb = -6;
-    
-    for (unsigned char c : input) {
-        val = (val << 8) + c;
-        valb += 8;
-        while (valb >= 0) {
-            output.push_back(base64_chars[(val >> valb) & 0x3F]);
-            valb -= 6;
-        }
-    }
-    
-    if (valb > -6) {
-        output.push_back(base64_chars[((val << 8) >> (valb + 8)) & 0x3F]);
-    }
-    
-    while (output.size() % 4) {
-        output.push_back('=');
-    }
-    
-    return output;
-}
-
 WebSocket::WebSocket() 
-    : m_fd(-1), m_is_external(false), m_connected(false), m_reader_stop(false) {
+    : m_fd(-1), m_is_external(false), m_connected(false), m_reader_stop(false),
+      m_notify_pending(false) {
     m_recv_queue.reserve(1024);
+    m_notify_pipe[0] = m_notify_pipe[1] = -1;
 }
 
 WebSocket::~WebSocket() {
     close();
+    if (m_notify_pipe[0] >= 0) ::close(m_notify_pipe[0]);
+    if (m_notify_pipe[1] >= 0) ::close(m_notify_pipe[1]);
+}
+
+int WebSocket::pollFd() const {
+    // pipe нужен только внешним циклам событий, создаем при первом запросе
+    std::lock_guard<std::mutex> lock(m_queue_mutex);
+    if (m_notify_pipe[0] < 0) {
+        if (pipe(m_notify_pipe) != 0) {
+            LOG_ERROR_F("Failed to create notify pipe: %s", strerror(errno));
+            m_notify_pipe[0] = m_notify_pipe[1] = -1;
+            return -1;
+        }
+        fcntl(m_notify_pipe[0], F_SETFL, fcntl(m_notify_pipe[0], F_GETFL) | O_NONBLOCK);
+        fcntl(m_notify_pipe[1], F_SETFL, fcntl(m_notify_pipe[1], F_GETFL) | O_NONBLOCK);
+        // Данные могли прийти раньше, чем появился pipe
+        if (!m_recv_queue.empty() || stagedRead() > 0) {
+            notifyReadable();
+        }
+    }
+    return m_notify_pipe[0];
+}
+
+void WebSocket::notifyReadable() const {
+    if (!m_notify_pending && m_notify_pipe[1] >= 0) {
+        uint8_t byte = 1;
+        m_notify_pending = ::write(m_notify_pipe[1], &byte, 1) == 1;
+    }
+}
+
+void WebSocket::clearReadable() {
+    if (m_notify_pending && m_recv_queue.empty() && stagedRead() == 0 && m_connected) {
+        uint8_t byte;
+        while (::read(m_notify_pipe[0], &byte, 1) == 1) {}
+        m_notify_pending = false;
+    }
 }
 
 bool WebSocket::open(const char* url, unsigned long baudrate) {
@@ -117,6 +126,7 @@ bool WebSocket::open(const char* url, unsigned long baudrate) {
     m_reader_thread = std::thread(&WebSocket::readerThread, this);
     
     LOG_INFO_F("WebSocket connected to %s", url);
+    STREAM_STAT_OPEN();
     return true;
 }
 
@@ -149,36 +159,45 @@ void WebSocket::close() {
     {
         std::lock_guard<std::mutex> lock(m_queue_mutex);
         m_recv_queue.clear();
+        releaseStaged(stagedRead());
+        // Будим ожидающих, чтобы они увидели закрытие
+        notifyReadable();
     }
 }
 
 int WebSocket::available() const {
     std::lock_guard<std::mutex> lock(m_queue_mutex);
-    return static_cast<int>(m_recv_queue.size());
+    return static_cast<int>(m_recv_queue.size() + stagedRead());
 }
 
 uint8_t WebSocket::read() {
-    std::lock_guard<std::mutex> lock(m_queue_mutex);
-    if (m_recv_queue.empty()) {
+    uint8_t byte;
+    if (read(&byte, 1) != 1) {
         return static_cast<uint8_t>(-1);
     }
-    uint8_t byte = m_recv_queue.front();
-    m_recv_queue.erase(m_recv_queue.begin());
     return byte;
 }
 
 size_t WebSocket::read(uint8_t* buffer, size_t length) {
     if (!buffer || length == 0) return 0;
-    
+    size_t bytes_read = take(buffer, length);
+    STREAM_STAT_DELIVERED(bytes_read);
+    return bytes_read;
+}
+
+size_t WebSocket::take(uint8_t* buffer, size_t length) {
+    // Сначала то, что уже перенесено в окно acquireRead - оно старше очереди
+    size_t bytes_read = takeStaged(buffer, length);
+
     std::lock_guard<std::mutex> lock(m_queue_mutex);
-    size_t bytes_to_read = std::min(length, m_recv_queue.size());
-    
-    for (size_t i = 0; i < bytes_to_read; ++i) {
-        buffer[i] = m_recv_queue[i];
+    size_t bytes_to_read = std::min(length - bytes_read, m_recv_queue.size());
+    if (bytes_to_read > 0) {
+        memcpy(buffer + bytes_read, m_recv_queue.data(), bytes_to_read);
+        m_recv_queue.erase(m_recv_queue.begin(), m_recv_queue.begin() + bytes_to_read);
+        bytes_read += bytes_to_read;
     }
-    
-    m_recv_queue.erase(m_recv_queue.begin(), m_recv_queue.begin() + bytes_to_read);
-    return bytes_to_read;
+    clearReadable();
+    return bytes_read;
 }
 
 size_t WebSocket::write(uint8_t byte) {
@@ -192,8 +211,145 @@ size_t WebSocket::write(const uint8_t* buffer, size_t length) {
 
     std::vector<uint8_t> frame;
     buildWebSocketFrame(buffer, length, frame, true);
-    
+    return sendFrame(frame, length);
+}
+
+size_t WebSocket::writev(const struct iovec* iov, int iovcnt) {
+    if (!m_connected || m_fd < 0 || !iov || iovcnt <= 0) {
+        return 0;
+    }
+
+    size_t length = 0;
+    for (int i = 0; i < iovcnt; ++i) {
+        length += iov[i].iov_len;
+    }
+    if (length == 0) {
+        return 0;
+    }
+
+    // Все сегменты уходят одним фреймом
+    std::vector<uint8_t> frame;
+    buildWebSocketFrame(iov, iovcnt, frame, true);
+    return sendFrame(frame, length);
+}
+
+size_t WebSocket::readv(const struct iovec* iov, int iovcnt) {
+    if (!iov || iovcnt <= 0) return 0;
+
+    size_t total = 0;
+    for (int i = 0; i < iovcnt; ++i) {
+        if (iov[i].iov_len == 0) continue;
+        size_t n = take(static_cast<uint8_t*>(iov[i].iov_base), iov[i].iov_len);
+        total += n;
+        if (n != iov[i].iov_len) break;
+    }
+    STREAM_STAT_DELIVERED(total);
+    return total;
+}
+
+sbu_t WebSocket::acquireRead(size_t min) {
+    if (min == 0) min = 1;
+    if (stagedRead() < min) {
+        // Под короткой блокировкой переносим очередь в окно: пустое окно
+        // просто меняется с ней местами, без копирования. Дальше окно
+        // принадлежит читающему, поток приема пишет в новую очередь
+        std::lock_guard<std::mutex> lock(m_queue_mutex);
+        if (!m_recv_queue.empty()) {
+            if (stagedRead() == 0) {
+                m_rx_stage.clear();
+                m_rx_stage_head = 0;
+                m_rx_stage.swap(m_recv_queue);
+            } else {
+                memcpy(growStage(m_recv_queue.size()), m_recv_queue.data(), m_recv_queue.size());
+                m_recv_queue.clear();
+            }
+        }
+        if (stagedRead() < min) {
+            return makeView(nullptr, 0);
+        }
+    }
+    return makeView(m_rx_stage.data() + m_rx_stage_head, stagedRead());
+}
+
+void WebSocket::releaseRead(size_t n) {
+    n = std::min(n, stagedRead());
+    releaseStaged(n);
+    STREAM_STAT_DELIVERED(n);
+    if (stagedRead() == 0) {
+        std::lock_guard<std::mutex> lock(m_queue_mutex);
+        clearReadable();
+    }
+}
+
+// Максимальный заголовок клиентского фрейма: 2 + 8 (длина) + 4 (маска)
+#define WS_MAX_HEADER 14
+
+sbu_t WebSocket::acquireWrite(size_t min) {
+    if (m_tx_frame.size() < WS_MAX_HEADER + min) {
+        m_tx_frame.resize(WS_MAX_HEADER + min);
+    }
+    return makeView(m_tx_frame.data() + WS_MAX_HEADER, m_tx_frame.size() - WS_MAX_HEADER);
+}
+
+size_t WebSocket::commitWrite(size_t n) {
+    if (!m_connected || m_fd < 0 || n == 0 || WS_MAX_HEADER + n > m_tx_frame.size()) {
+        return 0;
+    }
+
+    // Заголовок пишется вплотную перед нагрузкой, маска накладывается на месте
+    uint8_t header[WS_MAX_HEADER];
+    size_t header_len = 0;
+    header[header_len++] = 0x82;
+    if (n < 126) {
+        header[header_len++] = 0x80 | static_cast<uint8_t>(n);
+    } else if (n < 65536) {
+        header[header_len++] = 0x80 | 126;
+        header[header_len++] = (n >> 8) & 0xFF;
+        header[header_len++] = n & 0xFF;
+    } else {
+        header[header_len++] = 0x80 | 127;
+        for (int i = 7; i >= 0; --i) {
+            header[header_len++] = (n >> (8*i)) & 0xFF;
+        }
+    }
+    const uint8_t mask[4] = {0x12, 0x34, 0x56, 0x78};
+    memcpy(header + header_len, mask, 4);
+    header_len += 4;
+
+    uint8_t* payload = m_tx_frame.data() + WS_MAX_HEADER;
+    for (size_t i = 0; i < n; ++i) {
+        payload[i] ^= mask[i % 4];
+    }
+
+    uint8_t* frame = payload - header_len;
+    memcpy(frame, header, header_len);
+    STREAM_STAT_START(started);
+    STREAM_TRACE_START(trace_started);
+    ssize_t bytes_sent = ::send(m_fd, frame, header_len + n, MSG_NOSIGNAL);
+    STREAM_TRACE_SPAN(TRACE_WS_SEND, trace_started, m_fd, bytes_sent);
+    STREAM_STAT_WRITE_DONE(started);
+    STREAM_STAT_ADD(STREAM_STAT_SYSCALLS, 1);
+    if (bytes_sent < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            m_connected = false;
+        }
+        return 0;
+    }
+    STREAM_STAT_ADD(STREAM_STAT_OPS_OUT, 1);
+    STREAM_STAT_ADD(STREAM_STAT_BYTES_OUT, n);
+    if (static_cast<size_t>(bytes_sent) < header_len + n) {
+        STREAM_STAT_ADD(STREAM_STAT_PARTIAL_WRITES, 1);
+    }
+    return n;
+}
+
+size_t WebSocket::sendFrame(const std::vector<uint8_t>& frame, size_t payload_len) {
+    STREAM_STAT_START(started);
+    STREAM_TRACE_START(trace_started);
     ssize_t bytes_sent = ::send(m_fd, frame.data(), frame.size(), MSG_NOSIGNAL);
+    STREAM_TRACE_SPAN(TRACE_WS_SEND, trace_started, m_fd, bytes_sent);
+    STREAM_STAT_WRITE_DONE(started);
+    STREAM_STAT_ADD(STREAM_STAT_SYSCALLS, 1);
     if (bytes_sent < 0) {
         if (errno != EAGAIN && errno != EWOULDBLOCK) {
             m_connected = false;
@@ -201,7 +357,12 @@ size_t WebSocket::write(const uint8_t* buffer, size_t length) {
         return 0;
     }
     
-    return length;
+    STREAM_STAT_ADD(STREAM_STAT_OPS_OUT, 1);
+    STREAM_STAT_ADD(STREAM_STAT_BYTES_OUT, payload_len);
+    if (static_cast<size_t>(bytes_sent) < frame.size()) {
+        STREAM_STAT_ADD(STREAM_STAT_PARTIAL_WRITES, 1);
+    }
+    return payload_len;
 }
 
 void WebSocket::flush() {
@@ -219,7 +380,12 @@ bool WebSocket::poll(int timeout_ms) {
     pfd.fd = m_fd;
     pfd.events = POLLIN;
     
+    STREAM_STAT_START(wait_started);
     int ret = ::poll(&pfd, 1, timeout_ms);
+    STREAM_STAT_ADD(STREAM_STAT_SYSCALLS, 1);
+    if (timeout_ms != 0) {
+        STREAM_STAT_WAIT_DONE(wait_started);
+    }
     return (ret > 0 && (pfd.revents & POLLIN));
 }
 
@@ -291,6 +457,18 @@ std::string WebSocket::generateWebSocketKey() {
 }
 
 void WebSocket::buildWebSocketFrame(const uint8_t* data, size_t len, std::vector<uint8_t>& frame, bool binary) {
+    struct iovec iov;
+    iov.iov_base = const_cast<uint8_t*>(data);
+    iov.iov_len = len;
+    buildWebSocketFrame(&iov, 1, frame, binary);
+}
+
+void WebSocket::buildWebSocketFrame(const struct iovec* iov, int iovcnt, std::vector<uint8_t>& frame, bool binary) {
+    size_t len = 0;
+    for (int i = 0; i < iovcnt; ++i) {
+        len += iov[i].iov_len;
+    }
+
     frame.clear();
     frame.reserve(len + 14);
     
@@ -315,9 +493,13 @@ void WebSocket::buildWebSocketFrame(const uint8_t* data, size_t len, std::vector
     uint8_t mask[4] = {0x12, 0x34, 0x56, 0x78};
     frame.insert(frame.end(), mask, mask + 4);
     
-    // Masked payload
-    for (size_t i = 0; i < len; ++i) {
-        frame.push_back(data[i] ^ mask[i % 4]);
+    // Masked payload, индекс маски сквозной по всем сегментам
+    size_t pos = 0;
+    for (int i = 0; i < iovcnt; ++i) {
+        const uint8_t* data = static_cast<const uint8_t*>(iov[i].iov_base);
+        for (size_t j = 0; j < iov[i].iov_len; ++j, ++pos) {
+            frame.push_back(data[j] ^ mask[pos % 4]);
+        }
     }
 }
 
@@ -343,9 +525,18 @@ void WebSocket::readerThread() {
         timeout.tv_sec = 0;
         timeout.tv_usec = 10000; // 10ms
         
+        STREAM_TRACE_START(wait_started);
         int select_ret = select(m_fd + 1, &read_fds, nullptr, nullptr, &timeout);
+        // Пустые 10-мс таймауты простоя не пишем: они вытеснили бы из кольца
+        // все полезные события
+        if (select_ret != 0) {
+            STREAM_TRACE_SPAN(TRACE_WS_WAIT, wait_started, m_fd, select_ret);
+        }
         if (select_ret > 0 && FD_ISSET(m_fd, &read_fds)) {
+            STREAM_TRACE_START(recv_started);
             ssize_t bytes_received = ::recv(m_fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+            STREAM_TRACE_SPAN(TRACE_WS_RECV, recv_started, m_fd, bytes_received);
+            STREAM_STAT_ADD(STREAM_STAT_SYSCALLS, 1);
             if (bytes_received > 0) {
                 processWebSocketData(buffer, static_cast<size_t>(bytes_received));
             } else if (bytes_received == 0) {
@@ -360,6 +551,10 @@ void WebSocket::readerThread() {
             }
         }
     }
+
+    // Соединение потеряно - будим ожидающих на pollFd()
+    std::lock_guard<std::mutex> lock(m_queue_mutex);
+    notifyReadable();
 }
 
 void WebSocket::processWebSocketData(const uint8_t* data, size_t len) {
@@ -378,16 +573,28 @@ void WebSocket::processWebSocketData(const uint8_t* data, size_t len) {
     while (offset < combined_data.size()) {
         auto result = parseWebSocketFrame(combined_data.data() + offset, combined_data.size() - offset);
         if (result.complete) {
-            if (result.opcode == 1 || result.opcode == 2) { // Text or binary
+            STREAM_STAT_ADD(STREAM_STAT_FRAMES, 1);
+            STREAM_TRACE_EVENT(TRACE_WS_FRAME, result.opcode, result.payload.size(), result.frame_length);
+            if ((result.opcode == 1 || result.opcode == 2) && hasCallbacks()) {
+                // Push-модель: отдаем прямо из потока чтения, мимо очереди
+                STREAM_STAT_DELIVERED(result.payload.size());
+                dispatchMessage(result.payload.data(), result.payload.size());
+                dispatchData(result.payload.data(), result.payload.size());
+            } else if (result.opcode == 1 || result.opcode == 2) { // Text or binary
                 std::lock_guard<std::mutex> lock(m_queue_mutex);
                 m_recv_queue.insert(m_recv_queue.end(), result.payload.begin(), result.payload.end());
                 
                 // Ограничение размера буфера как в uStream
                 if (m_recv_queue.size() > 8192) {
                     m_recv_queue.erase(m_recv_queue.begin(), m_recv_queue.begin() + 1024);
+                    STREAM_STAT_ADD(STREAM_STAT_DROPPED, 1024);
+                    STREAM_TRACE_EVENT(TRACE_WS_DROP, 0, 1024, m_recv_queue.size());
                 }
+                notifyReadable();
             } else if (result.opcode == 8) { // Close frame
+                std::lock_guard<std::mutex> lock(m_queue_mutex);
                 m_connected = false;
+                notifyReadable();
                 break;
             }
             offset += result.frame_length;
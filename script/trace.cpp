@@ -0,0 +1,300 @@
+#include "trace.hpp"
+
+#if STREAM_TRACE && !defined(ARDUINO) && !defined(FURI_OS)
+#include "common.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stddef.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+std::atomic<uTraceHeader *> uTrace::s_header{nullptr};
+std::atomic<uint32_t> uTrace::s_generation{0};
+size_t uTrace::s_size = 0;
+
+static const size_t TRACE_PAGE = 4096;
+
+static size_t round_up(size_t value, size_t align)
+{
+    return (value + align - 1) & ~(align - 1);
+}
+
+static uTraceRing *ring_at(uTraceHeader *header, uint32_t index)
+{
+    return reinterpret_cast<uTraceRing *>(
+        reinterpret_cast<uint8_t *>(header) + header->rings_offset + header->ring_stride * index);
+}
+
+static void define_builtin_events()
+{
+    uTrace::defineEvent(TRACE_CRASH, "crash");
+    uTrace::defineEvent(TRACE_MARK, "mark");
+    uTrace::defineEvent(TRACE_SERIAL_READ, "serial.read");
+    uTrace::defineEvent(TRACE_SERIAL_WRITE, "serial.write");
+    uTrace::defineEvent(TRACE_SERIAL_POLL, "serial.poll");
+    uTrace::defineEvent(TRACE_SERIAL_PACKET, "serial.packet");
+    uTrace::defineEvent(TRACE_WS_WAIT, "ws.wait");
+    uTrace::defineEvent(TRACE_WS_RECV, "ws.recv");
+    uTrace::defineEvent(TRACE_WS_FRAME, "ws.frame");
+    uTrace::defineEvent(TRACE_WS_DROP, "ws.drop");
+    uTrace::defineEvent(TRACE_WS_SEND, "ws.send");
+}
+
+bool uTrace::init(const char *path, uint32_t rings, uint32_t ring_capacity)
+{
+    if (s_header.load(std::memory_order_acquire))
+    {
+        LOG_WARN("uTrace already initialized");
+        return false;
+    }
+    if (rings == 0 || ring_capacity == 0 || (ring_capacity & (ring_capacity - 1)) != 0)
+    {
+        LOG_ERROR_F("uTrace ring capacity %u must be a power of two", (unsigned)ring_capacity);
+        return false;
+    }
+
+    size_t stride = round_up(offsetof(uTraceRing, records) + sizeof(uTraceRecord) * ring_capacity, 64);
+    size_t rings_offset = round_up(sizeof(uTraceHeader), TRACE_PAGE);
+    size_t size = round_up(rings_offset + stride * rings, TRACE_PAGE);
+
+    void *mem = MAP_FAILED;
+    if (path)
+    {
+        int fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0)
+        {
+            LOG_ERROR_F("uTrace failed to open '%s': %s", path, strerror(errno));
+            return false;
+        }
+        if (ftruncate(fd, (off_t)size) == 0)
+            mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mem == MAP_FAILED)
+            LOG_ERROR_F("uTrace failed to map '%s': %s", path, strerror(errno));
+        ::close(fd);
+    }
+    else
+    {
+        mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED)
+            LOG_ERROR_F("uTrace failed to allocate %zu bytes: %s", size, strerror(errno));
+    }
+    if (mem == MAP_FAILED)
+        return false;
+
+    // Страницы уже нулевые: кольца пусты, имена событий не заданы
+    uTraceHeader *header = static_cast<uTraceHeader *>(mem);
+    memcpy(header->magic, UTRACE_MAGIC, sizeof(header->magic));
+    header->version = UTRACE_VERSION;
+    header->record_size = sizeof(uTraceRecord);
+    header->ring_count = rings;
+    header->ring_capacity = ring_capacity;
+    header->ring_stride = stride;
+    header->rings_offset = rings_offset;
+    header->pid = (uint32_t)getpid();
+
+    struct timespec real;
+    clock_gettime(CLOCK_REALTIME, &real);
+    header->realtime_offset_ns = (int64_t)real.tv_sec * 1000000000LL + real.tv_nsec - (int64_t)now();
+
+    s_size = size;
+    s_header.store(header, std::memory_order_release);
+    s_generation.fetch_add(1, std::memory_order_acq_rel);
+    define_builtin_events();
+    return true;
+}
+
+void uTrace::shutdown()
+{
+    uTraceHeader *header = s_header.exchange(nullptr, std::memory_order_acq_rel);
+    if (!header)
+        return;
+    s_generation.fetch_add(1, std::memory_order_acq_rel);
+    msync(header, s_size, MS_SYNC);
+    munmap(header, s_size);
+    s_size = 0;
+}
+
+void uTrace::defineEvent(uint16_t event, const char *name)
+{
+    uTraceHeader *header = s_header.load(std::memory_order_acquire);
+    if (!header || event >= UTRACE_MAX_EVENTS || !name)
+        return;
+    strncpy(header->names[event], name, UTRACE_NAME_LEN - 1);
+}
+
+uTraceRing *uTrace::attach()
+{
+    // Поколение читаем до заголовка: если между ними пройдет init, следующая
+    // запись увидит новое поколение и подключится еще раз
+    t_generation = s_generation.load(std::memory_order_acquire);
+    uTraceHeader *header = s_header.load(std::memory_order_acquire);
+    t_ring = nullptr;
+    if (!header)
+        return nullptr;
+
+    // Колец не хватило - события этого потока теряются, но без повторных попыток
+    uint32_t index = header->rings_used.fetch_add(1, std::memory_order_relaxed);
+    if (index >= header->ring_count)
+        return nullptr;
+
+    uTraceRing *ring = ring_at(header, index);
+    ring->capacity = header->ring_capacity;
+#ifdef __linux__
+    ring->tid = (uint32_t)syscall(SYS_gettid);
+    pthread_getname_np(pthread_self(), ring->thread_name, sizeof(ring->thread_name));
+#else
+    ring->tid = index;
+#endif
+    t_ring = ring;
+    return ring;
+}
+
+bool uTrace::dump(const char *path)
+{
+    uTraceHeader *header = s_header.load(std::memory_order_acquire);
+    if (!header || !path)
+        return false;
+
+    int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        LOG_ERROR_F("uTrace failed to open '%s': %s", path, strerror(errno));
+        return false;
+    }
+
+    const uint8_t *data = reinterpret_cast<const uint8_t *>(header);
+    size_t written = 0;
+    while (written < s_size)
+    {
+        ssize_t n = ::write(fd, data + written, s_size - written);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        written += (size_t)n;
+    }
+    ::close(fd);
+    return written == s_size;
+}
+
+static const int crash_signals[] = {SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT};
+
+void uTrace::onCrash(int sig)
+{
+    // attach() не async-signal-safe (pthread_getname_np, syscall), поэтому
+    // пишем только в уже подключенное кольцо текущего поколения
+    if (t_ring && t_generation == s_generation.load(std::memory_order_acquire))
+        write(t_ring, TRACE_CRASH, (uint32_t)sig, 0, 0);
+    // MAP_SHARED-страницы попадут в файл и без msync, он лишь не ждет writeback
+    uTraceHeader *header = s_header.load(std::memory_order_relaxed);
+    if (header)
+        msync(header, s_size, MS_ASYNC);
+    raise(sig);
+}
+
+void uTrace::installCrashHandler()
+{
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = &uTrace::onCrash;
+    sa.sa_flags = SA_RESETHAND | SA_NODEFER;
+    sigemptyset(&sa.sa_mask);
+    for (int sig : crash_signals)
+        sigaction(sig, &sa, nullptr);
+}
+
+bool uTrace::decode(const char *path, FILE *out)
+{
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    struct stat st;
+    void *mem = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(uTraceHeader))
+        mem = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mem == MAP_FAILED)
+    {
+        fprintf(stderr, "%s: not a trace file\n", path);
+        return false;
+    }
+
+    const uTraceHeader *header = static_cast<const uTraceHeader *>(mem);
+    size_t size = (size_t)st.st_size;
+    if (memcmp(header->magic, UTRACE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != UTRACE_VERSION || header->record_size != sizeof(uTraceRecord) ||
+        header->rings_offset + header->ring_stride * header->ring_count > size)
+    {
+        fprintf(stderr, "%s: unsupported trace format\n", path);
+        munmap(mem, size);
+        return false;
+    }
+
+    struct Entry
+    {
+        const uTraceRecord *rec;
+        const uTraceRing *ring;
+    };
+    std::vector<Entry> entries;
+
+    uint32_t rings = std::min(header->rings_used.load(std::memory_order_relaxed), header->ring_count);
+    for (uint32_t i = 0; i < rings; i++)
+    {
+        const uTraceRing *ring = ring_at(const_cast<uTraceHeader *>(header), i);
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        uint64_t capacity = header->ring_capacity;
+        for (uint64_t seq = head > capacity ? head - capacity : 0; seq < head; seq++)
+        {
+            const uTraceRecord *rec = &ring->records[seq & (capacity - 1)];
+            if (rec->event != TRACE_NONE)
+                entries.push_back({rec, ring});
+        }
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b)
+              { return a.rec->ts_ns < b.rec->ts_ns; });
+
+    fprintf(out, "# pid %u, %u thread(s), %zu event(s)\n",
+            (unsigned)header->pid, (unsigned)rings, entries.size());
+    if (!entries.empty())
+    {
+        int64_t wall_ns = (int64_t)entries[0].rec->ts_ns + header->realtime_offset_ns;
+        time_t sec = (time_t)(wall_ns / 1000000000LL);
+        struct tm tm;
+        char when[32];
+        strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", localtime_r(&sec, &tm));
+        fprintf(out, "# first event at %s.%06ld\n", when, (long)(wall_ns % 1000000000LL / 1000));
+    }
+
+    uint64_t base = entries.empty() ? 0 : entries[0].rec->ts_ns;
+    for (const Entry &e : entries)
+    {
+        const uTraceRecord *rec = e.rec;
+        char unknown[16];
+        const char *name = rec->event < UTRACE_MAX_EVENTS ? header->names[rec->event] : "";
+        if (!name[0])
+        {
+            snprintf(unknown, sizeof(unknown), "event#%u", (unsigned)rec->event);
+            name = unknown;
+        }
+        fprintf(out, "%14.3f us  %-7u %-15.15s %-16s a0=%u a1=%lld a2=%llu\n",
+                (double)(rec->ts_ns - base) / 1000.0, (unsigned)e.ring->tid,
+                e.ring->thread_name, name, (unsigned)rec->a0,
+                (long long)rec->a1, (unsigned long long)rec->a2);
+    }
+
+    munmap(mem, size);
+    return true;
+}
+
+#endif // STREAM_TRACE
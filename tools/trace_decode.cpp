@@ -0,0 +1,25 @@
+/*
+ * trace_decode.cpp - текстовый вид бинарной трассы uTrace
+ *
+ * Читает файл из uTrace::init(path) (в том числе оставшийся после
+ * падения процесса) или из uTrace::dump(path).
+ *
+ * g++ -O2 -std=c++17 -DSTREAM_TRACE=1 -Iinclude tools/trace_decode.cpp script/trace.cpp -o trace_decode
+ * ./trace_decode stream.trace
+ */
+
+#include "trace.hpp"
+
+#if !STREAM_TRACE
+#error "build with -DSTREAM_TRACE=1"
+#endif
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <trace file>\n", argv[0]);
+        return 2;
+    }
+    return uTrace::decode(argv[1], stdout) ? 0 : 1;
+}